@@ -0,0 +1,970 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define __AL_ADPCM_SSE2 1
+#endif
+
+#include "al.h"
+#include "alAdpcm.h"
+
+/*
+ * The encoder works in spans of this many blocks, each starting from its
+ *  own warm-up of this many frames, so big uploads can be encoded in
+ *  parallel; see warmupIndex().
+ */
+#define ENCODE_SPAN_BLOCKS 256
+#define ENCODE_WARMUP_FRAMES 256
+
+static const ALint imaIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static const ALint imaStepTable[89] =
+{
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const ALint msAdaptTable[16] =
+{
+    230, 230, 230, 230, 307, 409, 512, 614,
+    768, 614, 512, 409, 307, 230, 230, 230
+};
+
+static const ALint msCoeff1[7] = { 256, 512, 0, 192, 240, 460, 392 };
+static const ALint msCoeff2[7] = { 0, -256, 0, 64, 0, -208, -232 };
+
+
+static ALsizei blockFramesFor(ALenum codec, ALsizei channels,
+                              ALsizei blockAlign)
+{
+    const ALsizei perChannel = blockAlign / channels;
+
+    if ((blockAlign <= 0) || ((blockAlign % channels) != 0))
+        return 0;
+    else if (perChannel > __AL_ADPCM_MAX_BLOCK_ALIGN)
+        return 0;
+
+    if (codec == __AL_ADPCM_IMA)
+    {
+        /* header, then whole 4-byte words of nibbles. */
+        if ((perChannel <= 4) || (((perChannel - 4) % 4) != 0))
+            return 0;
+        return ((perChannel - 4) * 2) + 1;
+    } /* if */
+
+    else if (codec == __AL_ADPCM_MS)
+    {
+        if (perChannel <= 7)
+            return 0;
+        return ((perChannel - 7) * 2) + 2;
+    } /* else if */
+
+    return 0;
+} /* blockFramesFor */
+
+
+static ALint readLE16(const ALubyte *ptr)
+{
+    return (ALint) ((ALshort) (ptr[0] | (ptr[1] << 8)));
+} /* readLE16 */
+
+
+static ALint clamp16(ALint sample)
+{
+    if (sample > 32767)
+        return 32767;
+    else if (sample < -32768)
+        return -32768;
+    return sample;
+} /* clamp16 */
+
+
+static ALint imaNibble(ALint nibble, ALint *pred, ALint *index)
+{
+    const ALint step = imaStepTable[*index];
+    ALint diff = step >> 3;
+
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+
+    *pred = clamp16((nibble & 8) ? (*pred - diff) : (*pred + diff));
+
+    *index += imaIndexTable[nibble & 7];
+    if (*index < 0)
+        *index = 0;
+    else if (*index > 88)
+        *index = 88;
+
+    return *pred;
+} /* imaNibble */
+
+
+/*
+ * Where the (k)th sample of channel (c) lives in a block. Sample zero (and
+ *  one, for MS) comes from the header instead.
+ */
+static ALint imaNibbleAt(const ALubyte *in, ALsizei channels, ALsizei c,
+                         ALsizei k)
+{
+    ALint byte;
+    k--;
+    byte = in[(channels * 4) + ((((k >> 3) * channels) + c) * 4) + ((k & 7) >> 1)];
+    return (k & 1) ? (byte >> 4) : (byte & 0xF);
+} /* imaNibbleAt */
+
+
+static ALint msNibbleAt(const ALubyte *in, ALsizei channels, ALsizei c,
+                        ALsizei k)
+{
+    const ALsizei i = ((k - 2) * channels) + c;
+    const ALint byte = in[(channels * 7) + (i >> 1)];
+    return (i & 1) ? (byte & 0xF) : (byte >> 4);
+} /* msNibbleAt */
+
+
+/*
+ * One channel of one block is a "stream": a decoder's state runs through
+ *  it from start to end and never depends on any other stream. These
+ *  decode one stream into (out), which points at that channel's first
+ *  sample in the interleaved output.
+ */
+static void decodeImaStream(const __alAdpcm *adpcm, const ALubyte *in,
+                            ALsizei c, ALshort *out)
+{
+    const ALsizei channels = adpcm->channels;
+    const ALsizei frames = adpcm->blockFrames;
+    const ALubyte *hdr = in + (c * 4);
+    ALint pred = readLE16(hdr);
+    ALint index = (hdr[2] > 88) ? 88 : hdr[2];
+    ALsizei k;
+
+    out[0] = (ALshort) pred;
+    for (k = 1; k < frames; k++)
+    {
+        const ALint nibble = imaNibbleAt(in, channels, c, k);
+        out[k * channels] = (ALshort) imaNibble(nibble, &pred, &index);
+    } /* for */
+} /* decodeImaStream */
+
+
+static void msHeader(const ALubyte *in, ALsizei channels, ALsizei c,
+                     ALint *coeff1, ALint *coeff2, ALint *delta,
+                     ALint *s1, ALint *s2)
+{
+    /* the header is field by field, each field for every channel. */
+    const ALint predictor = (in[c] > 6) ? 6 : in[c];
+    *coeff1 = msCoeff1[predictor];
+    *coeff2 = msCoeff2[predictor];
+    *delta = readLE16(in + channels + (c * 2));
+    if (*delta < 16)
+        *delta = 16;
+    *s1 = readLE16(in + (channels * 3) + (c * 2));
+    *s2 = readLE16(in + (channels * 5) + (c * 2));
+} /* msHeader */
+
+
+static ALint msAdapt(ALint nibble, ALint delta)
+{
+    /* the top clamp only matters for garbage data; don't overflow. */
+    delta = (msAdaptTable[nibble] * delta) >> 8;
+    if (delta < 16)
+        return 16;
+    else if (delta > 0x100000)
+        return 0x100000;
+    return delta;
+} /* msAdapt */
+
+
+static void decodeMsStream(const __alAdpcm *adpcm, const ALubyte *in,
+                           ALsizei c, ALshort *out)
+{
+    const ALsizei channels = adpcm->channels;
+    const ALsizei frames = adpcm->blockFrames;
+    ALint coeff1, coeff2, delta, s1, s2;
+    ALsizei k;
+
+    msHeader(in, channels, c, &coeff1, &coeff2, &delta, &s1, &s2);
+    out[0] = (ALshort) s2;
+    out[channels] = (ALshort) s1;
+
+    for (k = 2; k < frames; k++)
+    {
+        const ALint nibble = msNibbleAt(in, channels, c, k);
+        const ALint signedNibble = (nibble & 8) ? (nibble - 16) : nibble;
+        ALint pred = ((s1 * coeff1) + (s2 * coeff2)) >> 8;
+        pred = clamp16(pred + (signedNibble * delta));
+        s2 = s1;
+        s1 = pred;
+        out[k * channels] = (ALshort) pred;
+        delta = msAdapt(nibble, delta);
+    } /* for */
+} /* decodeMsStream */
+
+
+#if __AL_ADPCM_SSE2
+/*
+ * SSE2 decoders. A stream is inherently serial, each sample depending on
+ *  the last, so instead of vectorizing within a stream, these run four
+ *  streams side by side, one per lane: four blocks of mono, two blocks of
+ *  stereo, etc. The table lookups and nibble fetches are still scalar
+ *  (SSE2 has no gather), but all the arithmetic, clamping and state
+ *  tracking is done four at a time. Results are bit-exact with the
+ *  scalar decoders above.
+ */
+
+#define LANES 4
+
+/* clamp each lane of (x) to [lo, hi]; SSE2 has no 32-bit min/max. */
+static __m128i clamp32(__m128i x, __m128i lo, __m128i hi)
+{
+    __m128i mask = _mm_cmpgt_epi32(x, hi);
+    x = _mm_or_si128(_mm_and_si128(mask, hi), _mm_andnot_si128(mask, x));
+    mask = _mm_cmplt_epi32(x, lo);
+    return _mm_or_si128(_mm_and_si128(mask, lo), _mm_andnot_si128(mask, x));
+} /* clamp32 */
+
+
+/* low 32 bits of a 32x32 multiply, lane by lane; SSE2 has no mullo_epi32. */
+static __m128i mullo32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32),
+                                      _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+} /* mullo32 */
+
+
+/*
+ * Write eight steps' worth of results, (r[0]) through (r[7]) with one
+ *  lane per stream, to each stream's output starting at sample (first).
+ *  Transposing in registers first means a mono stream gets its eight
+ *  samples with one store instead of eight.
+ */
+static void storeLanes8(const __m128i *r, ALshort **out, ALsizei first,
+                        ALsizei channels)
+{
+    __m128i lane[LANES][2];
+    ALsizei half, i, j;
+
+    for (half = 0; half < 2; half++)
+    {
+        const __m128i *h = r + (half * 4);
+        const __m128i t0 = _mm_unpacklo_epi32(h[0], h[1]);
+        const __m128i t1 = _mm_unpacklo_epi32(h[2], h[3]);
+        const __m128i t2 = _mm_unpackhi_epi32(h[0], h[1]);
+        const __m128i t3 = _mm_unpackhi_epi32(h[2], h[3]);
+        lane[0][half] = _mm_unpacklo_epi64(t0, t1);
+        lane[1][half] = _mm_unpackhi_epi64(t0, t1);
+        lane[2][half] = _mm_unpacklo_epi64(t2, t3);
+        lane[3][half] = _mm_unpackhi_epi64(t2, t3);
+    } /* for */
+
+    for (i = 0; i < LANES; i++)
+    {
+        /* everything's already clamped, so the saturation is a no-op. */
+        const __m128i packed = _mm_packs_epi32(lane[i][0], lane[i][1]);
+        ALshort *dst = out[i] + (first * channels);
+        if (channels == 1)
+            _mm_storeu_si128((__m128i *) dst, packed);
+        else
+        {
+            ALshort tmp[8];
+            _mm_storeu_si128((__m128i *) tmp, packed);
+            for (j = 0; j < 8; j++)
+                dst[j * channels] = tmp[j];
+        } /* else */
+    } /* for */
+} /* storeLanes8 */
+
+
+static ALint readLE32(const ALubyte *ptr)
+{
+    return (ALint) (((ALuint) ptr[0]) | (((ALuint) ptr[1]) << 8) |
+                    (((ALuint) ptr[2]) << 16) | (((ALuint) ptr[3]) << 24));
+} /* readLE32 */
+
+
+static void decodeImaLanes(const __alAdpcm *adpcm, const ALubyte **in,
+                           const ALsizei *chan, ALshort **out)
+{
+    const ALsizei channels = adpcm->channels;
+    const ALsizei groups = (adpcm->blockFrames - 1) / 8;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i three = _mm_set1_epi32(3);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i eight = _mm_set1_epi32(8);
+    const __m128i fifteen = _mm_set1_epi32(15);
+    const __m128i maxIndex = _mm_set1_epi32(88);
+    const __m128i lo16 = _mm_set1_epi32(-32768);
+    const __m128i hi16 = _mm_set1_epi32(32767);
+    ALint lanePred[LANES];
+    ALint laneIndex[LANES];
+    __m128i pred, index;
+    __m128i r[8];
+    ALsizei i, g, j;
+
+    for (i = 0; i < LANES; i++)
+    {
+        const ALubyte *hdr = in[i] + (chan[i] * 4);
+        lanePred[i] = readLE16(hdr);
+        laneIndex[i] = (hdr[2] > 88) ? 88 : hdr[2];
+        out[i][0] = (ALshort) lanePred[i];
+    } /* for */
+
+    pred = _mm_loadu_si128((const __m128i *) lanePred);
+    index = _mm_loadu_si128((const __m128i *) laneIndex);
+
+    for (g = 0; g < groups; g++)
+    {
+        /* one little-endian word per lane is the next eight nibbles. */
+        __m128i words = _mm_setr_epi32(
+            readLE32(in[0] + (channels * 4) + (((g * channels) + chan[0]) * 4)),
+            readLE32(in[1] + (channels * 4) + (((g * channels) + chan[1]) * 4)),
+            readLE32(in[2] + (channels * 4) + (((g * channels) + chan[2]) * 4)),
+            readLE32(in[3] + (channels * 4) + (((g * channels) + chan[3]) * 4)));
+
+        for (j = 0; j < 8; j++)
+        {
+            const __m128i nibble = _mm_and_si128(words, fifteen);
+            __m128i step, diff, mask, adjust;
+
+            words = _mm_srli_epi32(words, 4);
+            step = _mm_setr_epi32(imaStepTable[laneIndex[0]],
+                                  imaStepTable[laneIndex[1]],
+                                  imaStepTable[laneIndex[2]],
+                                  imaStepTable[laneIndex[3]]);
+
+            /* diff = step/8, + step (bit 2), + step/2 (bit 1), + step/4 (bit 0). */
+            diff = _mm_srai_epi32(step, 3);
+            mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, four), four);
+            diff = _mm_add_epi32(diff, _mm_and_si128(mask, step));
+            adjust = mask;  /* keep bit 2 for the index update. */
+            mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, two), two);
+            diff = _mm_add_epi32(diff, _mm_and_si128(mask, _mm_srai_epi32(step, 1)));
+            mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, one), one);
+            diff = _mm_add_epi32(diff, _mm_and_si128(mask, _mm_srai_epi32(step, 2)));
+
+            /* bit 3 is the sign: negate with (x ^ -1) - -1. */
+            mask = _mm_cmpeq_epi32(_mm_and_si128(nibble, eight), eight);
+            diff = _mm_sub_epi32(_mm_xor_si128(diff, mask), mask);
+            pred = clamp32(_mm_add_epi32(pred, diff), lo16, hi16);
+            r[j] = pred;
+
+            /* imaIndexTable[n & 7] is -1 below 4, ((n & 3) * 2) + 2 above. */
+            adjust = _mm_or_si128(
+                _mm_and_si128(adjust,
+                    _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(nibble, three), 1), two)),
+                _mm_andnot_si128(adjust, _mm_set1_epi32(-1)));
+            index = clamp32(_mm_add_epi32(index, adjust), zero, maxIndex);
+            _mm_storeu_si128((__m128i *) laneIndex, index);
+        } /* for */
+
+        storeLanes8(r, out, 1 + (g * 8), channels);
+    } /* for */
+} /* decodeImaLanes */
+
+
+/*
+ * Nibbles (k) through (k + count - 1) of MS stream (c), packed into a word
+ *  in the order they're decoded, lowest first, so the SIMD loop can just
+ *  shift through them like it does for IMA.
+ */
+static ALint msNibbleWord(const ALubyte *in, ALsizei channels, ALsizei c,
+                          ALsizei k, ALsizei count)
+{
+    ALuint retval = 0;
+    ALsizei j;
+
+    if ((count == 8) && (channels == 1))
+    {
+        /* four bytes, high nibble first in each. */
+        const ALuint w = (ALuint) readLE32(in + 7 + ((k - 2) >> 1));
+        return (ALint) (((w >> 4) & 0x0F0F0F0F) | ((w & 0x0F0F0F0F) << 4));
+    } /* if */
+
+    else if ((count == 8) && (channels == 2))
+    {
+        /* eight bytes, one per frame; gather one side of each. */
+        const ALubyte *data = in + 14 + (k - 2);
+        for (j = 0; j < 2; j++)
+        {
+            ALuint w = (ALuint) readLE32(data + (j * 4));
+            w = (c == 0) ? ((w >> 4) & 0x0F0F0F0F) : (w & 0x0F0F0F0F);
+            w = (w | (w >> 4)) & 0x00FF00FF;
+            w = (w | (w >> 8)) & 0x0000FFFF;
+            retval |= w << (j * 16);
+        } /* for */
+        return (ALint) retval;
+    } /* else if */
+
+    for (j = 0; j < count; j++)
+        retval |= ((ALuint) msNibbleAt(in, channels, c, k + j)) << (j * 4);
+    return (ALint) retval;
+} /* msNibbleWord */
+
+
+static void decodeMsLanes(const __alAdpcm *adpcm, const ALubyte **in,
+                          const ALsizei *chan, ALshort **out)
+{
+    const ALsizei channels = adpcm->channels;
+    const ALsizei frames = adpcm->blockFrames;
+    const __m128i lo16 = _mm_set1_epi32(-32768);
+    const __m128i hi16 = _mm_set1_epi32(32767);
+    const __m128i mask16 = _mm_set1_epi32(0xFFFF);
+    const __m128i fifteen = _mm_set1_epi32(15);
+    const __m128i minDelta = _mm_set1_epi32(16);
+    const __m128i maxDelta = _mm_set1_epi32(0x100000);
+    ALint c1[LANES], c2[LANES], d[LANES], h1[LANES], h2[LANES];
+    ALint laneNibble[LANES];
+    ALint lanePred[LANES];
+    __m128i coeffs, delta, s1, s2;
+    __m128i r[8];
+    ALsizei i, j, k;
+
+    for (i = 0; i < LANES; i++)
+    {
+        msHeader(in[i], channels, chan[i], &c1[i], &c2[i], &d[i],
+                 &h1[i], &h2[i]);
+        out[i][0] = (ALshort) h2[i];
+        out[i][channels] = (ALshort) h1[i];
+    } /* for */
+
+    /* (coeff1, coeff2) as 16-bit pairs, for _mm_madd_epi16. */
+    coeffs = _mm_or_si128(
+                _mm_and_si128(_mm_loadu_si128((const __m128i *) c1), mask16),
+                _mm_slli_epi32(_mm_loadu_si128((const __m128i *) c2), 16));
+    delta = _mm_loadu_si128((const __m128i *) d);
+    s1 = _mm_loadu_si128((const __m128i *) h1);
+    s2 = _mm_loadu_si128((const __m128i *) h2);
+
+    for (k = 2; k < frames; k += 8)
+    {
+        const ALsizei count = ((frames - k) < 8) ? (frames - k) : 8;
+        __m128i words = _mm_setr_epi32(
+                            msNibbleWord(in[0], channels, chan[0], k, count),
+                            msNibbleWord(in[1], channels, chan[1], k, count),
+                            msNibbleWord(in[2], channels, chan[2], k, count),
+                            msNibbleWord(in[3], channels, chan[3], k, count));
+
+        for (j = 0; j < count; j++)
+        {
+            const __m128i nibble = _mm_and_si128(words, fifteen);
+            const __m128i signedNibble =
+                            _mm_srai_epi32(_mm_slli_epi32(nibble, 28), 28);
+            __m128i pred;
+
+            words = _mm_srli_epi32(words, 4);
+            _mm_storeu_si128((__m128i *) laneNibble, nibble);
+
+            /* history is always in 16-bit range: one madd does both taps. */
+            pred = _mm_madd_epi16(_mm_or_si128(_mm_and_si128(s1, mask16),
+                                               _mm_slli_epi32(s2, 16)),
+                                  coeffs);
+            pred = _mm_srai_epi32(pred, 8);
+            pred = _mm_add_epi32(pred, mullo32(signedNibble, delta));
+            pred = clamp32(pred, lo16, hi16);
+            s2 = s1;
+            s1 = pred;
+            r[j] = pred;
+
+            delta = mullo32(delta,
+                        _mm_setr_epi32(msAdaptTable[laneNibble[0]],
+                                       msAdaptTable[laneNibble[1]],
+                                       msAdaptTable[laneNibble[2]],
+                                       msAdaptTable[laneNibble[3]]));
+            delta = clamp32(_mm_srai_epi32(delta, 8), minDelta, maxDelta);
+        } /* for */
+
+        if (count == 8)
+            storeLanes8(r, out, k, channels);
+        else  /* the leftovers at the end of the block. */
+        {
+            for (j = 0; j < count; j++)
+            {
+                _mm_storeu_si128((__m128i *) lanePred, r[j]);
+                for (i = 0; i < LANES; i++)
+                    out[i][(k + j) * channels] = (ALshort) lanePred[i];
+            } /* for */
+        } /* else */
+    } /* for */
+} /* decodeMsLanes */
+#endif  /* __AL_ADPCM_SSE2 */
+
+
+/*
+ * Decode (count) blocks, block (blocks[i]) going to (outs[i]). Every
+ *  channel of every block is a separate stream, and streams are handed
+ *  to the SIMD decoders four at a time, so this is where batching pays:
+ *  mono needs four blocks to fill the lanes, stereo two.
+ */
+static void decodeBlocks(const __alAdpcm *adpcm, const ALsizei *blocks,
+                         ALshort **outs, ALsizei count)
+{
+    const ALsizei channels = adpcm->channels;
+    const ALsizei streams = count * channels;
+    ALsizei s = 0;
+
+    #if __AL_ADPCM_SSE2
+    for (; (s + LANES) <= streams; s += LANES)
+    {
+        const ALubyte *in[LANES];
+        ALsizei chan[LANES];
+        ALshort *out[LANES];
+        ALsizei i;
+
+        for (i = 0; i < LANES; i++)
+        {
+            const ALsizei b = (s + i) / channels;
+            chan[i] = (s + i) % channels;
+            in[i] = adpcm->blocks + (blocks[b] * adpcm->blockAlign);
+            out[i] = outs[b] + chan[i];
+        } /* for */
+
+        if (adpcm->codec == __AL_ADPCM_IMA)
+            decodeImaLanes(adpcm, in, chan, out);
+        else
+            decodeMsLanes(adpcm, in, chan, out);
+    } /* for */
+    #endif
+
+    for (; s < streams; s++)
+    {
+        const ALsizei b = s / channels;
+        const ALsizei c = s % channels;
+        const ALubyte *in = adpcm->blocks + (blocks[b] * adpcm->blockAlign);
+        if (adpcm->codec == __AL_ADPCM_IMA)
+            decodeImaStream(adpcm, in, c, outs[b] + c);
+        else
+            decodeMsStream(adpcm, in, c, outs[b] + c);
+    } /* for */
+} /* decodeBlocks */
+
+
+int __alAdpcmFormat(ALenum fmt, ALenum *codec, ALsizei *channels)
+{
+    switch (fmt)
+    {
+        case AL_FORMAT_MONO_IMA4:
+            *codec = __AL_ADPCM_IMA; *channels = 1; return 1;
+        case AL_FORMAT_STEREO_IMA4:
+            *codec = __AL_ADPCM_IMA; *channels = 2; return 1;
+        case AL_FORMAT_MONO_MSADPCM_SOFT:
+            *codec = __AL_ADPCM_MS; *channels = 1; return 1;
+        case AL_FORMAT_STEREO_MSADPCM_SOFT:
+            *codec = __AL_ADPCM_MS; *channels = 2; return 1;
+    } /* switch */
+
+    return 0;
+} /* __alAdpcmFormat */
+
+
+ALsizei __alAdpcmDefaultBlockAlign(ALenum fmt)
+{
+    ALenum codec;
+    ALsizei channels;
+
+    if (!__alAdpcmFormat(fmt, &codec, &channels))
+        return 0;
+    else if (codec == __AL_ADPCM_IMA)
+        return 36 * channels;  /* 65 frames. */
+    return 38 * channels;  /* 64 frames. */
+} /* __alAdpcmDefaultBlockAlign */
+
+
+ALsizei __alAdpcmBlockAlign(ALenum fmt, ALsizei blockFrames)
+{
+    ALenum codec;
+    ALsizei channels;
+    ALsizei retval;
+
+    if (!__alAdpcmFormat(fmt, &codec, &channels))
+        return 0;
+    else if (blockFrames == 0)
+        return __alAdpcmDefaultBlockAlign(fmt);
+    else if (blockFrames < 0)
+        return 0;
+    else if (codec == __AL_ADPCM_IMA)
+    {
+        if ((blockFrames < 9) || (((blockFrames - 1) % 8) != 0))
+            return 0;
+        retval = (((blockFrames - 1) / 2) + 4) * channels;
+    } /* else if */
+    else
+    {
+        if ((blockFrames < 4) || ((blockFrames % 2) != 0))
+            return 0;
+        retval = (((blockFrames - 2) / 2) + 7) * channels;
+    } /* else */
+
+    /* catches blocks too big for us. */
+    if (blockFramesFor(codec, channels, retval) != blockFrames)
+        return 0;
+    return retval;
+} /* __alAdpcmBlockAlign */
+
+
+ALsizei __alAdpcmBlockFrames(ALenum fmt, ALsizei blockAlign)
+{
+    ALenum codec;
+    ALsizei channels;
+
+    if (!__alAdpcmFormat(fmt, &codec, &channels))
+        return 0;
+    else if (blockAlign == 0)
+        blockAlign = __alAdpcmDefaultBlockAlign(fmt);
+    return blockFramesFor(codec, channels, blockAlign);
+} /* __alAdpcmBlockFrames */
+
+
+ALenum __alAdpcmInit(__alAdpcm *adpcm, ALenum fmt, const ALvoid *data,
+                     ALsizei size, ALsizei blockAlign, ALboolean copy)
+{
+    ALenum codec;
+    ALsizei channels;
+    ALsizei blockFrames;
+
+    memset(adpcm, '\0', sizeof (__alAdpcm));
+
+    if (!__alAdpcmFormat(fmt, &codec, &channels))
+        return AL_INVALID_ENUM;
+
+    if (blockAlign == 0)
+        blockAlign = __alAdpcmDefaultBlockAlign(fmt);
+
+    blockFrames = blockFramesFor(codec, channels, blockAlign);
+    if ((blockFrames == 0) || (data == NULL) || (size <= 0))
+        return AL_INVALID_VALUE;
+    else if ((size % blockAlign) != 0)
+        return AL_INVALID_VALUE;
+
+    if (!copy)
+        adpcm->blocks = (const ALubyte *) data;
+    else
+    {
+        ALubyte *blocks = (ALubyte *) malloc(size);
+        if (blocks == NULL)
+            return AL_OUT_OF_MEMORY;
+        memcpy(blocks, data, size);
+        adpcm->blocks = blocks;
+        adpcm->ownsBlocks = AL_TRUE;
+    } /* else */
+
+    adpcm->codec = codec;
+    adpcm->channels = channels;
+    adpcm->blockAlign = blockAlign;
+    adpcm->blockFrames = blockFrames;
+    adpcm->blockCount = size / blockAlign;
+    adpcm->frames = adpcm->blockCount * blockFrames;
+    return AL_NO_ERROR;
+} /* __alAdpcmInit */
+
+
+static ALint imaEncodeSample(ALint sample, ALint *pred, ALint *index)
+{
+    ALint step = imaStepTable[*index];
+    ALint diff = sample - *pred;
+    ALint nibble = 0;
+
+    if (diff < 0)
+    {
+        nibble = 8;
+        diff = -diff;
+    } /* if */
+
+    if (diff >= step) { nibble |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 1; }
+
+    /* track exactly what the decoder will reconstruct. */
+    imaNibble(nibble, pred, index);
+    return nibble;
+} /* imaEncodeSample */
+
+
+/* the shared state of one __alAdpcmEncode(). */
+typedef struct S_ALADPCMENCODEJOB
+{
+    const ALshort *pcm;
+    ALsizei frames;
+    ALsizei channels;
+    ALsizei blockAlign;
+    ALsizei blockFrames;
+    ALsizei blockCount;
+    ALubyte *blocks;
+} __alAdpcmEncodeJob;
+
+
+/*
+ * The step index a span starts with. Rather than wait for the previous
+ *  span to finish, run the encoder over the frames just before this one
+ *  and throw the nibbles away; the step size only needs a few dozen
+ *  samples to find the level again, and this way every span can start
+ *  at once.
+ */
+static ALint warmupIndex(const __alAdpcmEncodeJob *job, ALsizei first,
+                         ALsizei channel)
+{
+    const ALsizei start = (first > ENCODE_WARMUP_FRAMES) ?
+                            (first - ENCODE_WARMUP_FRAMES) : 0;
+    ALint pred = job->pcm[(start * job->channels) + channel];
+    ALint index = 0;
+    ALsizei frame;
+
+    for (frame = start + 1; frame < first; frame++)
+        imaEncodeSample(job->pcm[(frame * job->channels) + channel],
+                        &pred, &index);
+
+    return index;
+} /* warmupIndex */
+
+
+static void encodeSpan(void *data, ALsizei span)
+{
+    const __alAdpcmEncodeJob *job = (const __alAdpcmEncodeJob *) data;
+    const ALsizei channels = job->channels;
+    const ALsizei frames = job->frames;
+    const ALsizei groups = (job->blockFrames - 1) / 8;
+    const ALsizei firstBlock = span * ENCODE_SPAN_BLOCKS;
+    ALsizei lastBlock = firstBlock + ENCODE_SPAN_BLOCKS;
+    ALint index[2] = { 0, 0 };
+    ALsizei b, c, g, i;
+
+    if (lastBlock > job->blockCount)
+        lastBlock = job->blockCount;
+
+    for (c = 0; c < channels; c++)
+        index[c] = warmupIndex(job, firstBlock * job->blockFrames, c);
+
+    for (b = firstBlock; b < lastBlock; b++)
+    {
+        ALubyte *out = job->blocks + (b * job->blockAlign);
+        const ALsizei first = b * job->blockFrames;
+
+        for (c = 0; c < channels; c++)
+        {
+            /*
+             * The step index carries over from the last block, so the
+             *  encoder doesn't relearn the level at every block.
+             */
+            ALint pred = job->pcm[(first * channels) + c];
+            ALubyte *hdr = out + (c * 4);
+            ALsizei frame = first + 1;
+
+            hdr[0] = (ALubyte) (pred & 0xFF);
+            hdr[1] = (ALubyte) ((pred >> 8) & 0xFF);
+            hdr[2] = (ALubyte) index[c];
+            hdr[3] = 0;
+
+            for (g = 0; g < groups; g++)
+            {
+                ALubyte *word = out + (channels * 4) +
+                                    (((g * channels) + c) * 4);
+                for (i = 0; i < 8; i++, frame++)
+                {
+                    const ALint sample = (frame >= frames) ? 0 :
+                                            job->pcm[(frame * channels) + c];
+                    const ALint nibble = imaEncodeSample(sample, &pred,
+                                                         &index[c]);
+                    if (i & 1)
+                        word[i >> 1] |= (ALubyte) (nibble << 4);
+                    else
+                        word[i >> 1] = (ALubyte) nibble;
+                } /* for */
+            } /* for */
+        } /* for */
+    } /* for */
+} /* encodeSpan */
+
+
+ALenum __alAdpcmEncode(__alAdpcm *adpcm, const ALshort *pcm, ALsizei frames,
+                       ALsizei channels, ALsizei blockAlign,
+                       __alWorkerPool *pool)
+{
+    __alAdpcmEncodeJob job;
+    ALsizei blockFrames;
+    ALsizei blockCount;
+    ALubyte *blocks;
+
+    memset(adpcm, '\0', sizeof (__alAdpcm));
+
+    if ((channels != 1) && (channels != 2))
+        return AL_INVALID_VALUE;
+
+    if (blockAlign == 0)
+        blockAlign = 36 * channels;
+
+    blockFrames = blockFramesFor(__AL_ADPCM_IMA, channels, blockAlign);
+    if ((blockFrames == 0) || (pcm == NULL) || (frames <= 0))
+        return AL_INVALID_VALUE;
+
+    blockCount = (frames + (blockFrames - 1)) / blockFrames;
+    blocks = (ALubyte *) malloc(blockCount * blockAlign);
+    if (blocks == NULL)
+        return AL_OUT_OF_MEMORY;
+
+    job.pcm = pcm;
+    job.frames = frames;
+    job.channels = channels;
+    job.blockAlign = blockAlign;
+    job.blockFrames = blockFrames;
+    job.blockCount = blockCount;
+    job.blocks = blocks;
+
+    /* spans don't depend on each other; same output with or without a pool. */
+    __alWorkerPoolFor(pool, (blockCount + (ENCODE_SPAN_BLOCKS - 1)) /
+                            ENCODE_SPAN_BLOCKS, encodeSpan, &job);
+
+    adpcm->codec = __AL_ADPCM_IMA;
+    adpcm->channels = channels;
+    adpcm->blockAlign = blockAlign;
+    adpcm->blockFrames = blockFrames;
+    adpcm->blockCount = blockCount;
+    adpcm->frames = frames;
+    adpcm->blocks = blocks;
+    adpcm->ownsBlocks = AL_TRUE;
+    return AL_NO_ERROR;
+} /* __alAdpcmEncode */
+
+
+void __alAdpcmFree(__alAdpcm *adpcm)
+{
+    if (adpcm->ownsBlocks)
+        free((ALvoid *) adpcm->blocks);
+    memset(adpcm, '\0', sizeof (__alAdpcm));
+} /* __alAdpcmFree */
+
+
+void __alAdpcmDecodeBlock(const __alAdpcm *adpcm, ALsizei block,
+                          ALshort *out)
+{
+    decodeBlocks(adpcm, &block, &out, 1);
+} /* __alAdpcmDecodeBlock */
+
+
+void __alAdpcmDecodeBlocks(const __alAdpcm *adpcm, ALsizei first,
+                           ALsizei count, ALshort *out)
+{
+    const ALsizei stride = adpcm->blockFrames * adpcm->channels;
+    ALsizei blocks[16];
+    ALshort *outs[16];
+    ALsizei i;
+
+    while (count > 0)
+    {
+        const ALsizei batch = (count < 16) ? count : 16;
+        for (i = 0; i < batch; i++)
+        {
+            blocks[i] = first + i;
+            outs[i] = out + (i * stride);
+        } /* for */
+        decodeBlocks(adpcm, blocks, outs, batch);
+        first += batch;
+        count -= batch;
+        out += batch * stride;
+    } /* while */
+} /* __alAdpcmDecodeBlocks */
+
+
+void __alAdpcmCacheInit(__alAdpcmCache *cache)
+{
+    cache->samples = NULL;
+    cache->block[0] = cache->block[1] = cache->block[2] = -1;
+    cache->capacity = 0;
+} /* __alAdpcmCacheInit */
+
+
+void __alAdpcmCacheDeinit(__alAdpcmCache *cache)
+{
+    free(cache->samples);
+    __alAdpcmCacheInit(cache);
+} /* __alAdpcmCacheDeinit */
+
+
+int __alAdpcmCacheBind(__alAdpcmCache *cache, const __alAdpcm *adpcm)
+{
+    const ALsizei needed = adpcm->blockFrames * adpcm->channels;
+
+    if (needed > cache->capacity)
+    {
+        ALshort *ptr = (ALshort *) realloc(cache->samples,
+                                           sizeof (ALshort) * needed * 3);
+        if (ptr == NULL)
+            return 0;
+        cache->samples = ptr;
+        cache->capacity = needed;
+    } /* if */
+
+    cache->block[0] = cache->block[1] = cache->block[2] = -1;
+    return 1;
+} /* __alAdpcmCacheBind */
+
+
+const ALshort *__alAdpcmCacheFetch(__alAdpcmCache *cache,
+                                   const __alAdpcm *adpcm, ALsizei frame,
+                                   ALsizei *avail)
+{
+    const ALsizei block = frame / adpcm->blockFrames;
+    const ALsizei first = block * adpcm->blockFrames;
+    const ALsizei slot = block % 3;  /* neighbors never evict each other. */
+    ALshort *samples = cache->samples + (slot * cache->capacity);
+    ALsizei end = adpcm->frames - first;
+
+    if (cache->block[slot] != block)
+    {
+        /*
+         * We're probably playing forward, so decode the next block into
+         *  its slot while we're here; decoding two at once fills more
+         *  SIMD lanes than decoding them one at a time would. That slot
+         *  never holds the block before this one, which an interpolator
+         *  may still be reading.
+         */
+        const ALsizei next = block + 1;
+        const ALsizei other = next % 3;
+        ALsizei blocks[2];
+        ALshort *outs[2];
+        ALsizei count = 1;
+
+        blocks[0] = block;
+        outs[0] = samples;
+        if ((next < adpcm->blockCount) && (cache->block[other] != next))
+        {
+            blocks[1] = next;
+            outs[1] = cache->samples + (other * cache->capacity);
+            cache->block[other] = next;
+            count = 2;
+        } /* if */
+
+        decodeBlocks(adpcm, blocks, outs, count);
+        cache->block[slot] = block;
+    } /* if */
+
+    if (end > adpcm->blockFrames)
+        end = adpcm->blockFrames;
+
+    *avail = end - (frame - first);
+    return samples + ((frame - first) * adpcm->channels);
+} /* __alAdpcmCacheFetch */
+
+/* end of alAdpcm.c ... */
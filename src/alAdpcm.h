@@ -0,0 +1,170 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALADPCM_H_
+#define _INCL_ALADPCM_H_
+
+#include "alCore.h"
+#include "alWorker.h"
+
+/*
+ * Compressed buffer storage.
+ *
+ * Sixteen-bit PCM for a whole game's worth of sounds adds up. ADPCM is
+ *  about a quarter of the size and nearly free to decode, so the software
+ *  mixer can keep buffers in that form and decode them a block at a time
+ *  as they play, instead of expanding everything at upload time.
+ *
+ * Two codecs are handled, both in their usual .wav block layout:
+ *
+ *  - IMA ADPCM (AL_FORMAT_MONO_IMA4, AL_FORMAT_STEREO_IMA4). Each block
+ *    starts with a 4-byte header per channel (first sample, step index),
+ *    then four bytes of nibbles per channel in turn, low nibble first.
+ *    We can also produce this from 16-bit PCM at upload time, see
+ *    __alAdpcmEncode().
+ *  - Microsoft ADPCM (AL_FORMAT_MONO_MSADPCM_SOFT, ...STEREO...). Each
+ *    block starts with a 7-byte header per channel (predictor, delta and
+ *    two history samples), then nibbles, high nibble first, channels
+ *    interleaved nibble by nibble.
+ *
+ * Blocks decode independently of each other, which is the point: the
+ *  mixer can start anywhere, and each voice keeps a small cache of the
+ *  blocks around its playback cursor (__alAdpcmCache), so a block is
+ *  decoded once per pass instead of once per quantum that touches it.
+ *  The cache holds three blocks: the one being read, the one before it
+ *  (so an interpolating resampler reading back across a block boundary
+ *  doesn't thrash it) and the next one, which is decoded along with the
+ *  current one while playing forward.
+ *
+ * With SSE2, each channel of each block is a lane, and four are decoded
+ *  side by side; see decodeBlocks() in alAdpcm.c.
+ */
+
+#define __AL_ADPCM_IMA 1
+#define __AL_ADPCM_MS  2
+
+/* Largest block we accept, in bytes per channel. */
+#define __AL_ADPCM_MAX_BLOCK_ALIGN 4096
+
+typedef struct S_ALADPCM
+{
+    ALenum codec;            /* __AL_ADPCM_IMA or __AL_ADPCM_MS */
+    ALsizei channels;
+    ALsizei blockAlign;      /* bytes per block, all channels. */
+    ALsizei blockFrames;     /* sample frames per block. */
+    ALsizei blockCount;
+    ALsizei frames;          /* the last block may be partly padding. */
+    const ALubyte *blocks;
+    ALboolean ownsBlocks;    /* AL_FALSE if we point at static data. */
+} __alAdpcm;
+
+/*
+ * Figure out the codec and channel count of an AL format. Returns zero if
+ *  (fmt) isn't ADPCM.
+ */
+int __alAdpcmFormat(ALenum fmt, ALenum *codec, ALsizei *channels);
+
+/*
+ * The default block size for (fmt), in bytes, for when the application
+ *  doesn't say (AL_UNPACK_BLOCK_ALIGNMENT_SOFT): 65 frames for IMA, 64
+ *  for MS, like everyone else does. Zero if (fmt) isn't ADPCM.
+ */
+ALsizei __alAdpcmDefaultBlockAlign(ALenum fmt);
+
+/*
+ * Bytes in a (fmt) block of (blockFrames) sample frames, which is how
+ *  AL_UNPACK_BLOCK_ALIGNMENT_SOFT counts; zero asks for the default. IMA
+ *  blocks hold 8n+1 frames and MS blocks an even number. Returns zero if
+ *  (fmt) isn't ADPCM or can't have blocks that size.
+ */
+ALsizei __alAdpcmBlockAlign(ALenum fmt, ALsizei blockFrames);
+
+/*
+ * The other way around: sample frames in a (fmt) block of (blockAlign)
+ *  bytes, zero for the default. Returns zero if it can't be done.
+ */
+ALsizei __alAdpcmBlockFrames(ALenum fmt, ALsizei blockAlign);
+
+/*
+ * Set up (adpcm) with (size) bytes of already-compressed (fmt) data in
+ *  blocks of (blockAlign) bytes. If (copy) is AL_FALSE, (data) is used in
+ *  place and must outlive (adpcm); see uploadBufferStatic(). Returns
+ *  AL_INVALID_ENUM if (fmt) isn't ADPCM, AL_INVALID_VALUE if (size) or
+ *  (blockAlign) don't make sense, AL_OUT_OF_MEMORY, or AL_NO_ERROR.
+ */
+ALenum __alAdpcmInit(__alAdpcm *adpcm, ALenum fmt, const ALvoid *data,
+                     ALsizei size, ALsizei blockAlign, ALboolean copy);
+
+/*
+ * Compress (frames) frames of 16-bit, (channels)-channel PCM into IMA
+ *  ADPCM blocks of (blockAlign) bytes (zero for the default). The last
+ *  block is padded with silence. Returns AL_INVALID_VALUE,
+ *  AL_OUT_OF_MEMORY or AL_NO_ERROR.
+ *
+ * Long sounds are encoded in independent spans of blocks, spread across
+ *  (pool) if it isn't NULL. The encoder's step size normally follows the
+ *  signal from block to block; at the start of a span it's found again by
+ *  running over the frames just before, so the output doesn't depend on
+ *  how many threads did the work (which the sample pool relies on).
+ */
+ALenum __alAdpcmEncode(__alAdpcm *adpcm, const ALshort *pcm, ALsizei frames,
+                       ALsizei channels, ALsizei blockAlign,
+                       __alWorkerPool *pool);
+
+/* Release anything __alAdpcmInit() or __alAdpcmEncode() allocated. */
+void __alAdpcmFree(__alAdpcm *adpcm);
+
+/*
+ * Decode block (block) into (out), as (blockFrames * channels) 16-bit
+ *  samples, interleaved.
+ */
+void __alAdpcmDecodeBlock(const __alAdpcm *adpcm, ALsizei block,
+                          ALshort *out);
+
+/*
+ * Decode (count) blocks starting at (first) into (out), back to back. This
+ *  is much faster per block than __alAdpcmDecodeBlock() where SIMD is
+ *  available, since independent blocks are decoded in parallel lanes; use
+ *  it when expanding a whole buffer.
+ */
+void __alAdpcmDecodeBlocks(const __alAdpcm *adpcm, ALsizei first,
+                           ALsizei count, ALshort *out);
+
+
+typedef struct S_ALADPCMCACHE
+{
+    ALshort *samples;        /* three blocks' worth. */
+    ALsizei block[3];        /* which block is in each slot; -1 for none. */
+    ALsizei capacity;        /* samples per slot. */
+} __alAdpcmCache;
+
+/* The cache starts out empty; __alAdpcmCacheBind() sizes it. */
+void __alAdpcmCacheInit(__alAdpcmCache *cache);
+void __alAdpcmCacheDeinit(__alAdpcmCache *cache);
+
+/*
+ * Get the cache ready to play (adpcm), growing it if need be and
+ *  forgetting whatever it held. This may allocate, so call it when the
+ *  voice's buffer changes (commitSource() or thereabouts), never while
+ *  mixing. Returns zero if out of memory.
+ */
+int __alAdpcmCacheBind(__alAdpcmCache *cache, const __alAdpcm *adpcm);
+
+/*
+ * Mixer side. Returns the decoded, interleaved samples starting at sample
+ *  frame (frame), decoding a block if it isn't cached, and sets (*avail)
+ *  to the number of frames that can be read from there before the end of
+ *  that block (or of the data). (frame) must be less than adpcm->frames.
+ */
+const ALshort *__alAdpcmCacheFetch(__alAdpcmCache *cache,
+                                   const __alAdpcm *adpcm, ALsizei frame,
+                                   ALsizei *avail);
+
+#endif
+
+/* end of alAdpcm.h ... */
@@ -0,0 +1,186 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "al.h"
+#include "alBank.h"
+
+/* !!! FIXME: This is POSIX only; Windows wants CreateFileMapping(). */
+
+#define HEADER_SIZE 16
+#define ENTRY_SIZE 32
+
+static ALuint readUint32(const ALubyte *ptr)
+{
+    return ((ALuint) ptr[0]) | (((ALuint) ptr[1]) << 8) |
+           (((ALuint) ptr[2]) << 16) | (((ALuint) ptr[3]) << 24);
+} /* readUint32 */
+
+
+static unsigned long long readUint64(const ALubyte *ptr)
+{
+    return ((unsigned long long) readUint32(ptr)) |
+           (((unsigned long long) readUint32(ptr + 4)) << 32);
+} /* readUint64 */
+
+
+/*
+ * madvise() wants page boundaries, so round the range out to them.
+ *  Returns zero if the kernel didn't take the advice.
+ */
+static int adviseRange(const ALubyte *ptr, size_t len, int advice)
+{
+    const size_t pagesize = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t start = ((size_t) ptr) & ~(pagesize - 1);
+    const size_t end = ((size_t) ptr) + len;
+    return (madvise((void *) start, end - start, advice) == 0);
+} /* adviseRange */
+
+
+__alBank *__alBankOpen(const char *path, ALuint flags)
+{
+    __alBank *bank = NULL;
+    struct stat statbuf;
+    int mapflags = MAP_SHARED;
+    void *base;
+    #ifdef MADV_POPULATE_READ
+    int populate = 1;  /* cleared if the kernel is too old for it. */
+    #endif
+    ALuint i;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    if ((fstat(fd, &statbuf) == -1) || (statbuf.st_size < HEADER_SIZE))
+    {
+        close(fd);
+        return NULL;
+    } /* if */
+
+    #ifdef MAP_POPULATE
+    if (flags & __AL_BANK_POPULATE)
+        mapflags |= MAP_POPULATE;
+    #endif
+
+    base = mmap(NULL, (size_t) statbuf.st_size, PROT_READ, mapflags, fd, 0);
+    close(fd);  /* the mapping keeps its own reference to the file. */
+    if (base == MAP_FAILED)
+        return NULL;
+
+    bank = (__alBank *) malloc(sizeof (__alBank));
+    if (bank == NULL)
+    {
+        munmap(base, (size_t) statbuf.st_size);
+        return NULL;
+    } /* if */
+
+    bank->base = (const ALubyte *) base;
+    bank->size = (size_t) statbuf.st_size;
+    bank->count = readUint32(bank->base + 8);
+    bank->table = bank->base + HEADER_SIZE;
+
+    if ( (memcmp(bank->base, "ioALBANK", 8) != 0) ||
+         (bank->count > ((bank->size - HEADER_SIZE) / ENTRY_SIZE)) )
+    {
+        __alBankClose(bank);
+        return NULL;
+    } /* if */
+
+    /* the table is tiny and we'll want all of it. */
+    adviseRange(bank->table, bank->count * ENTRY_SIZE, MADV_WILLNEED);
+
+    for (i = 0; i < bank->count; i++)
+    {
+        const ALubyte *entry = bank->table + (i * ENTRY_SIZE);
+        const unsigned long long offset = readUint64(entry);
+        const unsigned long long len = readUint64(entry + 8);
+        const ALuint entryflags = readUint32(entry + 24);
+        int advice = MADV_SEQUENTIAL;
+
+        if ((offset > bank->size) || (len > (bank->size - offset)))
+        {
+            __alBankClose(bank);  /* entry runs off the end of the file. */
+            return NULL;
+        } /* if */
+
+        if ((len == 0) || (flags & __AL_BANK_POPULATE))
+            continue;  /* nothing to advise, or it's all faulted in. */
+
+        if (entryflags & __AL_BANKENTRY_HOT)
+        {
+            /*
+             * Fault hot entries in now if we can, not just start reading.
+             *  Kernels before 5.14 say EINVAL to MADV_POPULATE_READ even
+             *  if the headers have it; fall back to MADV_WILLNEED there,
+             *  and don't bother asking again for the rest of the bank.
+             *  Any other failure (a read error, say) just falls back for
+             *  this entry.
+             */
+            #ifdef MADV_POPULATE_READ
+            if (populate)
+            {
+                if (adviseRange(bank->base + offset, (size_t) len,
+                                MADV_POPULATE_READ))
+                    continue;
+                else if (errno == EINVAL)
+                    populate = 0;
+            } /* if */
+            #endif
+            advice = MADV_WILLNEED;
+        } /* if */
+        else if (entryflags & __AL_BANKENTRY_RANDOM)
+            advice = MADV_RANDOM;
+
+        adviseRange(bank->base + offset, (size_t) len, advice);  /* a hint. */
+    } /* for */
+
+    return bank;
+} /* __alBankOpen */
+
+
+void __alBankClose(__alBank *bank)
+{
+    if (bank != NULL)
+    {
+        munmap((void *) bank->base, bank->size);
+        free(bank);
+    } /* if */
+} /* __alBankClose */
+
+
+ALenum __alBankLoadBuffer(__alBank *bank, ALuint index, __alDevice *dev,
+                          __alBuffer *buf)
+{
+    const ALubyte *entry;
+    unsigned long long offset, len;
+
+    if (index >= bank->count)
+        return AL_INVALID_VALUE;
+
+    /* __alBankOpen() already made sure the entry is inside the file. */
+    entry = bank->table + (index * ENTRY_SIZE);
+    offset = readUint64(entry);
+    len = readUint64(entry + 8);
+    if (len > 0x7FFFFFFF)
+        return AL_INVALID_VALUE;  /* won't fit in an ALsizei. */
+
+    return __alBufferDataStatic(dev, buf, (ALenum) readUint32(entry + 16),
+                                bank->base + offset, (ALsizei) len,
+                                (ALsizei) readUint32(entry + 20));
+} /* __alBankLoadBuffer */
+
+/* end of alBank.c ... */
@@ -0,0 +1,85 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALBANK_H_
+#define _INCL_ALBANK_H_
+
+#include <stddef.h>
+
+#include "alCore.h"
+
+/*
+ * Memory-mapped sound banks.
+ *
+ * A bank is one big file packed full of sounds. Opening one maps the
+ *  whole file read-only and shared, and buffers made from its entries
+ *  point straight into the mapping through __alBufferDataStatic(). So
+ *  startup does no reads and no copies, pages come in from disk only
+ *  when something plays them, and every process that maps the same bank
+ *  shares the same page cache instead of each keeping a private copy.
+ *
+ * Each entry can ask for an access pattern hint, which becomes an
+ *  madvise() on its pages: "hot" entries are prefetched right away,
+ *  "random" entries turn off readahead (for banks of short one-shots
+ *  that are played in no particular order), and everything else is
+ *  treated as sequential. Opening with __AL_BANK_POPULATE prefaults the
+ *  entire file instead, for small banks that are all hot.
+ *
+ * The file format, all little endian:
+ *
+ *    8 bytes:  "ioALBANK"
+ *    uint32:   number of entries
+ *    uint32:   reserved, must be zero
+ *    per entry, 32 bytes each:
+ *      uint64: offset of the sample data from the start of the file
+ *      uint64: size of the sample data, in bytes
+ *      uint32: format (AL_FORMAT_MONO16, etc)
+ *      uint32: frequency
+ *      uint32: flags (__AL_BANKENTRY_*)
+ *      uint32: reserved, must be zero
+ *
+ * Sample data is used in place, so it should already be in the format
+ *  the mixer wants if you want the zero-copy path.
+ */
+
+#define __AL_BANK_POPULATE       (1 << 0)  /* prefault the whole file. */
+
+#define __AL_BANKENTRY_HOT       (1 << 0)  /* prefetch at open time. */
+#define __AL_BANKENTRY_RANDOM    (1 << 1)  /* no readahead. */
+
+typedef struct S_ALBANK
+{
+    const ALubyte *base;     /* the mapping. */
+    size_t size;
+    ALuint count;
+    const ALubyte *table;    /* first entry. */
+} __alBank;
+
+/*
+ * Map the bank at (path). (flags) is zero or __AL_BANK_POPULATE. Returns
+ *  NULL if the file is missing, malformed or can't be mapped.
+ */
+__alBank *__alBankOpen(const char *path, ALuint flags);
+
+/*
+ * Unmap a bank. Every buffer made from it must have been deleted or given
+ *  new data first, since they point into the mapping.
+ */
+void __alBankClose(__alBank *bank);
+
+/*
+ * Give (buf) the sample data of entry (index), without copying. Returns
+ *  AL_INVALID_VALUE for a bad index, or whatever __alBufferDataStatic()
+ *  does.
+ */
+ALenum __alBankLoadBuffer(__alBank *bank, ALuint index, __alDevice *dev,
+                          __alBuffer *buf);
+
+#endif
+
+/* end of alBank.h ... */
@@ -0,0 +1,621 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alCapture.h"
+
+/*
+ * What pump() writes into when the ring is (nearly) full; a multiple of
+ *  any frame size, and the least room we ever offer the device.
+ */
+#define SCRATCH_BYTES 4096
+
+/* deliveries we remember the timestamps of. */
+#define STAMP_COUNT 128
+
+/* the capture thread's polling limits, and where it starts. */
+#define MIN_POLL_MS 1
+#define MAX_POLL_MS 20
+#define FIRST_INTERVAL_MS 10
+
+/*
+ * Set up conversion from what the device gives us to what the ring holds,
+ *  if they differ. (converted) has room for a whole scratch buffer's worth.
+ */
+static ALenum initConverter(__alCapture *cap)
+{
+    __alConverter *conv;
+    ALenum err;
+
+    if ((cap->deviceFormat == cap->format) &&
+        (cap->deviceFrequency == cap->frequency))
+        return AL_NO_ERROR;  /* nothing to do. */
+
+    conv = (__alConverter *) malloc(sizeof (__alConverter));
+    if (conv == NULL)
+        return AL_OUT_OF_MEMORY;
+
+    err = __alConverterInit(conv, cap->deviceFormat, cap->deviceFrequency,
+                            cap->format, cap->frequency);
+    if (err != AL_NO_ERROR)
+    {
+        free(conv);
+        return err;
+    } /* if */
+
+    cap->converter = conv;
+    cap->converted = (ALubyte *) malloc(__alConverterMaxOutput(conv,
+                            SCRATCH_BYTES / cap->deviceFrameSize) *
+                            cap->frameSize);
+    return (cap->converted == NULL) ? AL_OUT_OF_MEMORY : AL_NO_ERROR;
+} /* initConverter */
+
+
+ALenum __alCaptureInit(__alCapture *cap, ALuint freq, ALenum fmt,
+                       ALsizei samples, ALuint deviceFreq,
+                       ALenum deviceFmt)
+{
+    const ALsizei framesize = __alFormatFrameSize(fmt);
+    __alRing *ring;
+    ALenum err;
+
+    if ((framesize == 0) || (__alFormatFrameSize(deviceFmt) == 0))
+        return AL_INVALID_ENUM;
+    else if ((samples <= 0) || (freq == 0))
+        return AL_INVALID_VALUE;
+    else if (samples > (0x40000000 / framesize))
+        return AL_INVALID_VALUE;  /* bigger than a ring can be. */
+
+    ring = (__alRing *) malloc(sizeof (__alRing));
+    if (ring == NULL)
+        return AL_OUT_OF_MEMORY;
+    else if (!__alRingInit(ring, (ALuint) (samples * framesize)))
+    {
+        free(ring);
+        return AL_OUT_OF_MEMORY;
+    } /* else if */
+
+    cap->frequency = freq;
+    cap->format = fmt;
+    cap->frameSize = framesize;
+    cap->ring = ring;
+    cap->scratch = (ALubyte *) malloc(SCRATCH_BYTES);
+    cap->deviceFrequency = deviceFreq;
+    cap->deviceFormat = deviceFmt;
+    cap->deviceFrameSize = __alFormatFrameSize(deviceFmt);
+    cap->converter = NULL;
+    cap->converted = NULL;
+    memset(cap->borrowed, '\0', sizeof (cap->borrowed));
+    cap->pumping = 0;
+    cap->stamps = (__alCaptureStamp *) calloc(STAMP_COUNT,
+                                              sizeof (__alCaptureStamp));
+    cap->stampCount = 0;
+    cap->wake = __alSemaphoreCreate(0);
+    cap->thread = NULL;
+    cap->quit = 0;
+    cap->capturing = AL_FALSE;
+    cap->pollMS = FIRST_INTERVAL_MS / 2;
+    cap->intervalMS = FIRST_INTERVAL_MS;
+    cap->lastDelivery = 0;
+    cap->overrunning = AL_FALSE;
+    cap->overruns = 0;
+    cap->dropped = 0;
+    cap->peakFill = 0;
+
+    if ((cap->scratch == NULL) || (cap->wake == NULL) ||
+        (cap->stamps == NULL))
+    {
+        __alCaptureDeinit(cap);
+        return AL_OUT_OF_MEMORY;
+    } /* if */
+
+    err = initConverter(cap);
+    if (err != AL_NO_ERROR)
+        __alCaptureDeinit(cap);
+
+    return err;
+} /* __alCaptureInit */
+
+
+void __alCaptureDeinit(__alCapture *cap)
+{
+    __alCaptureStop(cap);
+
+    if (cap->ring != NULL)
+    {
+        __alRingDeinit(cap->ring);
+        free(cap->ring);
+        cap->ring = NULL;
+    } /* if */
+
+    if (cap->wake != NULL)
+    {
+        __alSemaphoreDestroy(cap->wake);
+        cap->wake = NULL;
+    } /* if */
+
+    if (cap->converter != NULL)
+    {
+        __alConverterDeinit(cap->converter);
+        free(cap->converter);
+        cap->converter = NULL;
+    } /* if */
+
+    free(cap->converted);
+    cap->converted = NULL;
+    free(cap->stamps);
+    cap->stamps = NULL;
+    free(cap->scratch);
+    cap->scratch = NULL;
+} /* __alCaptureDeinit */
+
+
+/*
+ * Track how far apart the device's deliveries are, and look about twice
+ *  per delivery. The average is a little high when we poll slowly, but
+ *  that makes us poll faster, so it settles.
+ */
+static void adaptPolling(__alCapture *cap, ALsizei got)
+{
+    if (got > 0)
+    {
+        const unsigned long long now = __alTicksNS();
+        if (cap->lastDelivery != 0)
+        {
+            const unsigned long long gap = (now - cap->lastDelivery) / 1000000;
+            const ALuint gapMS = (gap > 1000) ? 1000 : (ALuint) gap;
+            cap->intervalMS = ((cap->intervalMS * 3) + gapMS) / 4;
+        } /* if */
+        cap->lastDelivery = now;
+    } /* if */
+
+    if ((cap->intervalMS / 2) < MIN_POLL_MS)
+        __alAtomicStore(&cap->pollMS, MIN_POLL_MS);
+    else if ((cap->intervalMS / 2) > MAX_POLL_MS)
+        __alAtomicStore(&cap->pollMS, MAX_POLL_MS);
+    else
+        __alAtomicStore(&cap->pollMS, cap->intervalMS / 2);
+} /* adaptPolling */
+
+
+static int captureThread(void *data)
+{
+    __alCapture *cap = (__alCapture *) data;
+
+    while (!__alAtomicLoad(&cap->quit))
+    {
+        ALsizei got = 0;
+        ALsizei more;
+
+        /* take everything that's there before going back to sleep. */
+        while ((more = __alCapturePump(cap)) > 0)
+            got += more;
+
+        adaptPolling(cap, got);
+
+        if (cap->interface->wait != NULL)
+            cap->interface->wait(cap->impl, cap->pollMS);
+        else
+            __alSemaphoreWaitTimeout(cap->wake, cap->pollMS);
+    } /* while */
+
+    return 0;
+} /* captureThread */
+
+
+/*
+ * (pumping) guards who may pump, and whether the capture thread is there
+ *  to do it; readers only pump for themselves when it isn't.
+ */
+static void lockPumping(__alCapture *cap)
+{
+    ALuint idle = 0;
+    while (!__alAtomicCAS(&cap->pumping, &idle, 1))
+    {
+        idle = 0;
+        __alThreadSleep(1);
+    } /* while */
+} /* lockPumping */
+
+
+void __alCaptureStart(__alCapture *cap)
+{
+    if (cap->capturing)
+        return;
+
+    lockPumping(cap);
+    cap->interface->start(cap->impl);
+    cap->capturing = AL_TRUE;
+    cap->intervalMS = FIRST_INTERVAL_MS;
+    cap->lastDelivery = 0;
+    adaptPolling(cap, 0);
+
+    /* if this fails, __alCaptureAvailable() pumps for us. */
+    cap->quit = 0;
+    cap->thread = __alThreadCreate(captureThread, cap);
+    __alAtomicStore(&cap->pumping, 0);
+} /* __alCaptureStart */
+
+
+void __alCaptureStop(__alCapture *cap)
+{
+    if (!cap->capturing)
+        return;
+
+    lockPumping(cap);
+    if (cap->thread != NULL)
+    {
+        __alAtomicStore(&cap->quit, 1);
+        __alSemaphorePost(cap->wake);
+        __alThreadWait(cap->thread);
+        cap->thread = NULL;
+    } /* if */
+
+    cap->interface->stop(cap->impl);
+    cap->capturing = AL_FALSE;
+
+    /* the device may still be holding some; that's the application's. */
+    while (__alCapturePump(cap) > 0)
+        /* keep going */ ;
+
+    __alAtomicStore(&cap->pumping, 0);
+} /* __alCaptureStop */
+
+
+/* only the pumping thread raises the peak; __alCaptureGetStats() resets it. */
+static void notePeak(__alCapture *cap)
+{
+    const ALuint fill = __alRingFill(cap->ring) / cap->frameSize;
+    ALuint peak = __alAtomicLoad(&cap->peakFill);
+    while ((fill > peak) && (!__alAtomicCAS(&cap->peakFill, &peak, fill)))
+        /* (peak) was reloaded; try again. */ ;
+} /* notePeak */
+
+
+/*
+ * Remember that the frame at ring byte (position) was captured at (ns).
+ *  Readers skip the slot while its sequence is odd, and if it changed
+ *  while they looked.
+ */
+static void stamp(__alCapture *cap, ALuint position, unsigned long long ns)
+{
+    __alCaptureStamp *slot = &cap->stamps[cap->stampCount % STAMP_COUNT];
+    __alAtomicAdd(&slot->sequence, 1);
+    __alAtomicStore(&slot->position, position);
+    __alAtomicStore(&slot->ns, ns);
+    __alAtomicAdd(&slot->sequence, 1);
+    cap->stampCount++;
+} /* stamp */
+
+
+/*
+ * Copy (frames) sample frames from (data), the first captured at (ns),
+ *  into the ring, or as many as fit; the rest are an overrun, and get
+ *  counted.
+ */
+static ALsizei keep(__alCapture *cap, const ALubyte *data, ALsizei frames,
+                    unsigned long long ns)
+{
+    const ALsizei framesize = cap->frameSize;
+    const ALsizei room = (ALsizei) (__alRingWritable(cap->ring) / framesize);
+
+    if (frames > room)
+    {
+        if (!cap->overrunning)
+            __alAtomicAdd(&cap->overruns, 1);
+        cap->overrunning = AL_TRUE;
+        __alAtomicAdd(&cap->dropped, frames - room);
+        frames = room;
+    } /* if */
+    else
+    {
+        cap->overrunning = AL_FALSE;
+    } /* else */
+
+    if (frames > 0)
+    {
+        stamp(cap, cap->ring->writePos, ns);
+        __alRingWrite(cap->ring, data, (ALuint) (frames * framesize));
+    } /* if */
+
+    notePeak(cap);
+    return frames;
+} /* keep */
+
+
+/*
+ * Call the device's pump(), and make sure we know when what it gave us
+ *  was captured. Returns bytes, at most (bufsize).
+ */
+static ALsizei devicePump(__alCapture *cap, ALubyte *buf, ALsizei bufsize,
+                          unsigned long long *ns)
+{
+    ALsizei got;
+
+    *ns = 0;
+    got = cap->interface->pump(cap->impl, buf, bufsize, ns);
+    if (got <= 0)
+        return 0;
+    else if (got > bufsize)
+        got = bufsize;  /* !!! FIXME: the device scribbled on us. */
+
+    if (*ns == 0)  /* it doesn't know; say the last frame just came in. */
+    {
+        const unsigned long long frames = got / cap->deviceFrameSize;
+        *ns = __alTicksNS() - ((frames * 1000000000ULL) /
+                               cap->deviceFrequency);
+    } /* if */
+
+    return got;
+} /* devicePump */
+
+
+/* pump() into the scratch buffer; returns whole device frames. */
+static ALsizei pumpToScratch(__alCapture *cap, unsigned long long *ns)
+{
+    return devicePump(cap, cap->scratch, SCRATCH_BYTES, ns) /
+           cap->deviceFrameSize;
+} /* pumpToScratch */
+
+
+/*
+ * The device isn't giving us what the application wants. pump() into the
+ *  scratch buffer, and convert straight into the ring if there's room for
+ *  the most that could come out, or into (converted) and copy what fits.
+ */
+static ALsizei pumpConverted(__alCapture *cap)
+{
+    unsigned long long ns;
+    const ALsizei frames = pumpToScratch(cap, &ns);
+    long long shift;
+    ALuint avail;
+    ALubyte *span;
+    ALsizei out;
+
+    if (frames == 0)
+        return 0;
+
+    /*
+     * The first frame out is usually from a little before the first frame
+     *  in, but it can be a little after; see __alConverterOffset().
+     */
+    shift = (long long) ((__alConverterOffset(cap->converter) *
+                          1000000000.0) / cap->deviceFrequency);
+    if (shift < 0)
+        ns -= (unsigned long long) -shift;
+    else
+        ns += (unsigned long long) shift;
+
+    span = __alRingWriteSpan(cap->ring, &avail);
+    out = __alConverterMaxOutput(cap->converter, frames);
+    if ((ALuint) (out * cap->frameSize) > avail)
+    {
+        out = __alConverterRun(cap->converter, cap->scratch, frames,
+                               cap->converted);
+        return keep(cap, cap->converted, out, ns);
+    } /* if */
+
+    out = __alConverterRun(cap->converter, cap->scratch, frames, span);
+    if (out > 0)
+    {
+        stamp(cap, cap->ring->writePos, ns);
+        __alRingCommit(cap->ring, (ALuint) (out * cap->frameSize));
+    } /* if */
+
+    cap->overrunning = AL_FALSE;
+    notePeak(cap);
+    return out;
+} /* pumpConverted */
+
+
+ALsizei __alCapturePump(__alCapture *cap)
+{
+    const ALsizei framesize = cap->frameSize;
+    unsigned long long ns;
+    ALuint avail;
+    ALubyte *span;
+    ALsizei got;
+
+    if (cap->converter != NULL)
+        return pumpConverted(cap);
+
+    /*
+     * The ring is full, or nearly, or its free space is split at the end.
+     *  pump() into the scratch buffer instead, so the device always has a
+     *  decent amount of room and doesn't back up.
+     */
+    span = __alRingWriteSpan(cap->ring, &avail);
+    if (avail < SCRATCH_BYTES)
+    {
+        got = pumpToScratch(cap, &ns);
+        return (got == 0) ? 0 : keep(cap, cap->scratch, got, ns);
+    } /* if */
+
+    /* the usual case: straight into the ring. */
+    avail -= avail % framesize;
+    got = devicePump(cap, span, (ALsizei) avail, &ns);
+    got -= got % framesize;
+    if (got == 0)
+        return 0;
+
+    stamp(cap, cap->ring->writePos, ns);
+    __alRingCommit(cap->ring, (ALuint) got);
+    cap->overrunning = AL_FALSE;
+    notePeak(cap);
+    return got / framesize;
+} /* __alCapturePump */
+
+
+void __alCaptureGetStats(__alCapture *cap, __alCaptureStats *stats)
+{
+    stats->overruns = __alAtomicLoad(&cap->overruns);
+    stats->dropped = __alAtomicLoad(&cap->dropped);
+    stats->fill = (ALsizei) (__alRingFill(cap->ring) / cap->frameSize);
+    stats->peakFill = (ALsizei) __alAtomicExchange(&cap->peakFill, 0);
+    stats->capacity = (ALsizei) (cap->ring->capacity / cap->frameSize);
+    stats->pollMS = __alAtomicLoad(&cap->pollMS);
+} /* __alCaptureGetStats */
+
+
+static ALboolean validReader(__alCapture *cap, ALint reader)
+{
+    if ((reader < 0) || (reader >= __AL_MAX_CAPTURE_READERS))
+        return AL_FALSE;
+    else if ((__alAtomicLoad(&cap->ring->readers) & (1 << reader)) == 0)
+        return AL_FALSE;
+    return AL_TRUE;
+} /* validReader */
+
+
+ALint __alCaptureAddReader(__alCapture *cap)
+{
+    const ALint retval = __alRingAddReader(cap->ring);
+    if (retval > 0)
+        cap->borrowed[retval] = 0;
+    return retval;
+} /* __alCaptureAddReader */
+
+
+void __alCaptureRemoveReader(__alCapture *cap, ALint reader)
+{
+    if (reader > 0)
+        __alRingRemoveReader(cap->ring, reader);
+} /* __alCaptureRemoveReader */
+
+
+ALsizei __alCaptureAvailable(__alCapture *cap, ALint reader)
+{
+    ALuint idle = 0;
+
+    if (!validReader(cap, reader))
+        return 0;
+
+    /*
+     * If there's no thread to pump for us, whichever reader gets here first
+     *  does it. If someone else has the lock, what's there will do.
+     */
+    if (__alAtomicCAS(&cap->pumping, &idle, 1))
+    {
+        if ((cap->capturing) && (cap->thread == NULL))
+            __alCapturePump(cap);
+        __alAtomicStore(&cap->pumping, 0);
+    } /* if */
+
+    return (ALsizei) (__alRingReadable(cap->ring, reader) / cap->frameSize);
+} /* __alCaptureAvailable */
+
+
+ALenum __alCaptureSamples(__alCapture *cap, ALint reader, ALvoid *buffer,
+                          ALsizei samples)
+{
+    if (!validReader(cap, reader))
+        return AL_INVALID_VALUE;
+    else if (cap->borrowed[reader] > 0)
+        return AL_INVALID_OPERATION;  /* they'd be read out from under it. */
+    else if ((samples < 0) || (samples > __alCaptureAvailable(cap, reader)))
+        return AL_INVALID_VALUE;
+
+    __alRingRead(cap->ring, reader, buffer,
+                 (ALuint) (samples * cap->frameSize));
+    return AL_NO_ERROR;
+} /* __alCaptureSamples */
+
+
+ALenum __alCaptureAcquire(__alCapture *cap, ALint reader,
+                          const ALvoid **span, ALsizei *samples)
+{
+    ALuint avail;
+
+    if (!validReader(cap, reader))
+        return AL_INVALID_VALUE;
+
+    __alCaptureAvailable(cap, reader);  /* pumps, if there's no thread. */
+
+    /* ring capacity is a power of two, so frames never straddle the end. */
+    *span = (const ALvoid *) __alRingReadSpan(cap->ring, reader, &avail);
+    *samples = (ALsizei) (avail / cap->frameSize);
+    cap->borrowed[reader] = *samples;
+    return AL_NO_ERROR;
+} /* __alCaptureAcquire */
+
+
+ALenum __alCaptureRelease(__alCapture *cap, ALint reader, ALsizei samples)
+{
+    if (!validReader(cap, reader))
+        return AL_INVALID_VALUE;
+    else if ((samples < 0) || (samples > cap->borrowed[reader]))
+        return AL_INVALID_OPERATION;
+
+    __alRingRelease(cap->ring, reader, (ALuint) (samples * cap->frameSize));
+    cap->borrowed[reader] -= samples;
+    return AL_NO_ERROR;
+} /* __alCaptureRelease */
+
+/* Is a stamp (d) bytes behind our frame nearer than one (best) behind? */
+static ALboolean nearer(ALint d, ALint best)
+{
+    if (d >= 0)  /* the newest stamp at or before us wins... */
+        return ((best < 0) || (d < best)) ? AL_TRUE : AL_FALSE;
+    /* ...but if they're all after us, take the oldest. */
+    return ((best < 0) && (d > best)) ? AL_TRUE : AL_FALSE;
+} /* nearer */
+
+
+ALenum __alCaptureTimestamp(__alCapture *cap, ALint reader,
+                            unsigned long long *ns)
+{
+    ALboolean found = AL_FALSE;
+    unsigned long long bestNS = 0;
+    ALint best = 0;
+    ALuint readPos;
+    long long frames;
+    ALsizei i;
+
+    if (!validReader(cap, reader))
+        return AL_INVALID_VALUE;
+
+    readPos = __alAtomicLoad(&cap->ring->readPos[reader]);
+    for (i = 0; i < STAMP_COUNT; i++)
+    {
+        __alCaptureStamp *slot = &cap->stamps[i];
+        const ALuint sequence = __alAtomicLoad(&slot->sequence);
+        ALuint position;
+        unsigned long long when;
+        ALint d;
+
+        if ((sequence == 0) || (sequence & 1))
+            continue;  /* never used, or being rewritten. */
+
+        position = __alAtomicLoad(&slot->position);
+        when = __alAtomicLoad(&slot->ns);
+        if (__alAtomicLoad(&slot->sequence) != sequence)
+            continue;  /* rewritten while we looked. */
+
+        d = (ALint) (readPos - position);
+        if ((!found) || (nearer(d, best)))
+        {
+            found = AL_TRUE;
+            best = d;
+            bestNS = when;
+        } /* if */
+    } /* for */
+
+    if (!found)
+        return AL_INVALID_OPERATION;
+
+    /* count on from the stamp (or back, if it's after us) at the rate. */
+    frames = (long long) (best / cap->frameSize);
+    *ns = bestNS + (unsigned long long) ((frames * 1000000000LL) /
+                                         (long long) cap->frequency);
+    return AL_NO_ERROR;
+} /* __alCaptureTimestamp */
+
+/* end of alCapture.c ... */
@@ -0,0 +1,186 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALCAPTURE_H_
+#define _INCL_ALCAPTURE_H_
+
+#include "alCore.h"
+#include "alConvert.h"
+#include "alRing.h"
+#include "alThread.h"
+
+/*
+ * The core side of capture devices.
+ *
+ * Captured audio goes from the device's pump() method into a ring
+ *  (alRing.h), and alcCaptureSamples() copies it out to the application.
+ *  The ring is lock-free: one thread pumps, the application reads, and
+ *  neither waits for the other.
+ *  pump() writes straight into the ring's free space, which is always
+ *  one contiguous span when the ring is mirrored, so nothing is copied
+ *  on the way in. Applications that can work from the ring itself can
+ *  borrow the data there with __alCaptureAcquire(), so nothing is copied
+ *  on the way out, either.
+ *
+ * One microphone often feeds several things at once: an encoder, voice
+ *  activity detection, a recorder. Rather than open the device again,
+ *  they can each add a reader, with its own cursor into the same ring.
+ *  Every reader sees every frame, and nothing is copied per reader; the
+ *  ring's space is only reused once the slowest reader is past it, so
+ *  a reader that stops reading will cause overruns for everyone. Reader
+ *  zero is the one alcCaptureSamples() uses, and is always there.
+ *
+ * Every delivery from pump() is stamped with when its first frame was
+ *  captured, by the device if it knows, or by us if not. The stamps are
+ *  kept next to the ring, keyed by ring position, in a small table of
+ *  the most recent ones, and __alCaptureTimestamp() works out any
+ *  reader's next frame from the nearest stamp and the sample rate. Each
+ *  slot has a sequence number, odd while the producer is rewriting it,
+ *  so readers can look without locking and just skip a slot that's
+ *  changing under them.
+ *
+ * If the device can't deliver the format or rate the application asked
+ *  for, a converter (alConvert.h) sits between pump() and the ring, so
+ *  the ring always holds what the application wants. The device's data
+ *  goes to a scratch buffer first, and is converted straight into the
+ *  ring's free space when there's room for all of it.
+ *
+ * The pumping thread is ours. While the device is started, a capture
+ *  thread drains pump() into the ring, so the application never has to
+ *  poll. pump() may hold data back until it has a big block, so rather
+ *  than spin on it, the thread keeps a running average of how far apart
+ *  deliveries are and looks about twice per delivery (1 to 20ms). If the
+ *  device has a wait() method, the thread sleeps in that instead, and
+ *  wakes when data arrives.
+ *
+ * If the application falls behind and the ring fills up, the thread keeps
+ *  pumping, so the device doesn't back up, but throws the new data away:
+ *  that's an overrun, and __alCaptureGetStats() counts them, along with
+ *  the frames lost and how full the ring has been. If the thread can't
+ *  be started, the readers do the pumping instead, one at a time.
+ */
+
+/*
+ * Set up (cap), whose interface and impl have been filled in by a
+ *  successful open(), to hold at least (samples) sample frames of (fmt)
+ *  at (freq), which is what the application asked for. (deviceFreq) and
+ *  (deviceFmt) are what open() said it will really deliver; if they're
+ *  different, capture converts. Returns AL_INVALID_ENUM for an unknown
+ *  format, AL_INVALID_VALUE for a bad size, AL_OUT_OF_MEMORY, or
+ *  AL_NO_ERROR.
+ */
+ALenum __alCaptureInit(__alCapture *cap, ALuint freq, ALenum fmt,
+                       ALsizei samples, ALuint deviceFreq,
+                       ALenum deviceFmt);
+
+/*
+ * Stop capturing, if need be, and free what __alCaptureInit() allocated.
+ *  Doesn't close the device.
+ */
+void __alCaptureDeinit(__alCapture *cap);
+
+/*
+ * alcCaptureStart() and alcCaptureStop(). Start starts the device and
+ *  the capture thread; stop stops them, and pumps one last time, so what
+ *  was captured before the stop can still be read.
+ */
+void __alCaptureStart(__alCapture *cap);
+void __alCaptureStop(__alCapture *cap);
+
+/*
+ * Move whatever the device has into the ring, converted if need be, as
+ *  much as fits. Only one thread may pump a given capture device, and
+ *  that's the capture thread while it runs. Returns the number of sample
+ *  frames added, in the application's format.
+ */
+ALsizei __alCapturePump(__alCapture *cap);
+
+typedef struct S_ALCAPTURESTATS
+{
+    ALuint overruns;         /* times the ring filled while capturing. */
+    ALuint dropped;          /* sample frames thrown away for it. */
+    ALsizei fill;            /* frames held for the slowest reader. */
+    ALsizei peakFill;        /* most waiting since the last call. */
+    ALsizei capacity;        /* most the ring can hold. */
+    ALuint pollMS;           /* how often the capture thread looks. */
+} __alCaptureStats;
+
+/*
+ * How capture is keeping up. Any thread may ask; the overrun counts are
+ *  since the device was opened, and the peak is since the last call.
+ */
+void __alCaptureGetStats(__alCapture *cap, __alCaptureStats *stats);
+
+/*
+ * Add a reader, which sees everything captured from now on. Returns its
+ *  number, for the calls below, or -1 if there are already
+ *  __AL_MAX_CAPTURE_READERS. Remove it when it's done, or the ring fills
+ *  up behind it. Any thread may add or remove readers, but a reader
+ *  mustn't be in use while it's being removed.
+ */
+ALint __alCaptureAddReader(__alCapture *cap);
+void __alCaptureRemoveReader(__alCapture *cap, ALint reader);
+
+/*
+ * Sample frames ready for (reader); reader zero's is ALC_CAPTURE_SAMPLES.
+ *  Zero for a reader that doesn't exist.
+ */
+ALsizei __alCaptureAvailable(__alCapture *cap, ALint reader);
+
+/*
+ * Copy (samples) sample frames to (buffer), for (reader); reader zero's
+ *  is the guts of alcCaptureSamples(). Returns AL_INVALID_VALUE
+ *  (ALC_INVALID_VALUE to the application) if that many aren't ready or
+ *  there's no such reader, AL_NO_ERROR otherwise.
+ *
+ * Each reader may be on its own thread, but only one thread may use a
+ *  given reader at a time.
+ */
+ALenum __alCaptureSamples(__alCapture *cap, ALint reader, ALvoid *buffer,
+                          ALsizei samples);
+
+/*
+ * Zero-copy reads. Acquire points (*span) at the reader's oldest sample
+ *  frames, right in the ring, and sets (*samples) to how many are there
+ *  in one piece: everything that's ready if the ring is mirrored, or up
+ *  to the end of the buffer if not (acquire again after releasing to get
+ *  the rest). The frames are read-only, and stay put until they're
+ *  released, so an encoder can work straight from the ring.
+ *
+ * Release hands back the first (samples) acquired frames; the rest stay
+ *  borrowed. Acquiring again is fine; it starts from the oldest frame
+ *  that's still borrowed. __alCaptureSamples() returns AL_INVALID_OPERATION
+ *  while anything is borrowed, and so does releasing more than was
+ *  acquired. Borrowing is per reader, and so are the threading rules.
+ */
+ALenum __alCaptureAcquire(__alCapture *cap, ALint reader,
+                          const ALvoid **span, ALsizei *samples);
+ALenum __alCaptureRelease(__alCapture *cap, ALint reader, ALsizei samples);
+
+/* One delivery's stamp; see __alCaptureTimestamp(). */
+typedef struct S_ALCAPTURESTAMP
+{
+    ALuint sequence;          /* atomic; odd mid-write, zero if unused. */
+    ALuint position;          /* atomic; ring byte position of frame one. */
+    unsigned long long ns;    /* atomic; __alTicksNS() clock. */
+} __alCaptureStamp;
+
+/*
+ * When (reader)'s next frame was captured, in nanoseconds on the
+ *  __alTicksNS() clock, in (*ns). If nothing is waiting for the reader,
+ *  it's when the next frame should arrive. Returns AL_INVALID_VALUE if
+ *  there's no such reader, AL_INVALID_OPERATION if nothing has been
+ *  captured yet, AL_NO_ERROR otherwise. Same threading rules as the
+ *  reads.
+ */
+ALenum __alCaptureTimestamp(__alCapture *cap, ALint reader,
+                            unsigned long long *ns);
+
+#endif
+
+/* end of alCapture.h ... */
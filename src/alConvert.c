@@ -0,0 +1,423 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define __AL_CONVERT_SSE2 1
+#endif
+
+#include "al.h"
+#include "alConvert.h"
+#include "alSample.h"
+
+/* input frames converted per step; the float scratch is sized by this. */
+#define CHUNK_FRAMES 256
+
+/* frames the resampler keeps between steps: one behind, two ahead. */
+#define HISTORY_FRAMES 3
+
+/* adding and taking away 1.5 * 2^23 rounds a float to nearest-even. */
+#define ROUND_MAGIC 12582912.0f
+
+
+static int formatInfo(ALenum fmt, ALsizei *channels, ALboolean *is8bit)
+{
+    switch (fmt)
+    {
+        case AL_FORMAT_MONO8: *channels = 1; *is8bit = AL_TRUE; return 1;
+        case AL_FORMAT_STEREO8: *channels = 2; *is8bit = AL_TRUE; return 1;
+        case AL_FORMAT_MONO16: *channels = 1; *is8bit = AL_FALSE; return 1;
+        case AL_FORMAT_STEREO16: *channels = 2; *is8bit = AL_FALSE; return 1;
+    } /* switch */
+
+    return 0;
+} /* formatInfo */
+
+
+ALsizei __alConverterMaxOutput(const __alConverter *conv, ALsizei frames)
+{
+    unsigned long long retval;
+
+    if (conv->srcRate == conv->dstRate)
+        return frames;
+
+    /* what's held back can come out now, and rounding can add one more. */
+    retval = ((unsigned long long) (frames + HISTORY_FRAMES)) * conv->dstRate;
+    retval = (retval + (conv->srcRate - 1)) / conv->srcRate;
+    return (ALsizei) (retval + 2);
+} /* __alConverterMaxOutput */
+
+
+ALenum __alConverterInit(__alConverter *conv, ALenum srcFormat,
+                         ALuint srcRate, ALenum dstFormat, ALuint dstRate)
+{
+    ALboolean is8bit;
+    ALsizei outFrames;
+
+    memset(conv, '\0', sizeof (__alConverter));
+    if (!formatInfo(srcFormat, &conv->srcChannels, &is8bit))
+        return AL_INVALID_ENUM;
+    else if (!formatInfo(dstFormat, &conv->dstChannels, &is8bit))
+        return AL_INVALID_ENUM;
+    else if ((srcRate == 0) || (dstRate == 0))
+        return AL_INVALID_VALUE;
+
+    conv->srcFormat = srcFormat;
+    conv->srcFrameSize = __alFormatFrameSize(srcFormat);
+    conv->srcRate = srcRate;
+    conv->dstFormat = dstFormat;
+    conv->dstFrameSize = __alFormatFrameSize(dstFormat);
+    conv->dstRate = dstRate;
+    conv->step = (((unsigned long long) srcRate) << 32) / dstRate;
+
+    /* one frame of silence behind the first real one, for the cubic. */
+    conv->position = 1ULL << 32;
+    conv->historyFrames = 1;
+    conv->history = (ALfloat *) calloc((CHUNK_FRAMES + HISTORY_FRAMES) *
+                                        conv->dstChannels, sizeof (ALfloat));
+
+    outFrames = __alConverterMaxOutput(conv, CHUNK_FRAMES);
+    conv->output = (ALfloat *) malloc(outFrames * conv->dstChannels *
+                                      sizeof (ALfloat));
+
+    if ((conv->history == NULL) || (conv->output == NULL))
+    {
+        __alConverterDeinit(conv);
+        return AL_OUT_OF_MEMORY;
+    } /* if */
+
+    return AL_NO_ERROR;
+} /* __alConverterInit */
+
+
+void __alConverterDeinit(__alConverter *conv)
+{
+    free(conv->history);
+    free(conv->output);
+    memset(conv, '\0', sizeof (__alConverter));
+} /* __alConverterDeinit */
+
+
+static void decodeUint8(ALfloat *dst, const ALubyte *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_CONVERT_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+    for (; (i + 8) <= samples; i += 8)
+    {
+        const __m128i v = _mm_loadl_epi64((const __m128i *) (src + i));
+        const __m128i w = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+        dst[i] = ((ALfloat) (((ALint) src[i]) - 128)) * (1.0f / 128.0f);
+} /* decodeUint8 */
+
+
+static void monoToStereo(ALfloat *dst, const ALfloat *src, ALsizei frames)
+{
+    ALsizei i = 0;
+
+    #if __AL_CONVERT_SSE2
+    for (; (i + 4) <= frames; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + (i * 2), _mm_unpacklo_ps(v, v));
+        _mm_storeu_ps(dst + (i * 2) + 4, _mm_unpackhi_ps(v, v));
+    } /* for */
+    #endif
+
+    for (; i < frames; i++)
+        dst[i * 2] = dst[(i * 2) + 1] = src[i];
+} /* monoToStereo */
+
+
+static void stereoToMono(ALfloat *dst, const ALfloat *src, ALsizei frames)
+{
+    ALsizei i = 0;
+
+    #if __AL_CONVERT_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; (i + 4) <= frames; i += 4)
+    {
+        const __m128 a = _mm_loadu_ps(src + (i * 2));
+        const __m128 b = _mm_loadu_ps(src + (i * 2) + 4);
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    } /* for */
+    #endif
+
+    for (; i < frames; i++)
+        dst[i] = (src[i * 2] + src[(i * 2) + 1]) * 0.5f;
+} /* stereoToMono */
+
+
+/* (frames) of input to float, in the output's channel layout, at (dst). */
+static void expand(const __alConverter *conv, const ALvoid *src,
+                   ALsizei frames, ALfloat *dst)
+{
+    const ALsizei samples = frames * conv->srcChannels;
+    ALfloat decoded[CHUNK_FRAMES * 2];
+    ALfloat *out = (conv->srcChannels == conv->dstChannels) ? dst : decoded;
+
+    if ((conv->srcFormat == AL_FORMAT_MONO8) ||
+        (conv->srcFormat == AL_FORMAT_STEREO8))
+        decodeUint8(out, (const ALubyte *) src, samples);
+    else
+        __alSampleDecode(AL_STORAGE_INT16_IOAL, out, src, 0, samples);
+
+    if (out == dst)
+        return;
+    else if (conv->dstChannels == 2)
+        monoToStereo(dst, decoded, frames);
+    else
+        stereoToMono(dst, decoded, frames);
+} /* expand */
+
+
+/*
+ * Clamp like _mm_min_ps() and _mm_max_ps() do, NaNs included, and round
+ *  to nearest-even like _mm_cvtps_epi32() does, so both paths agree.
+ */
+static ALint packSample(ALfloat f, ALfloat scale)
+{
+    const ALfloat hi = scale - 1.0f;
+    const ALfloat lo = -scale;
+    ALfloat v = f * scale;
+    v = (v < hi) ? v : hi;
+    v = (v > lo) ? v : lo;
+    return (ALint) ((v + ROUND_MAGIC) - ROUND_MAGIC);
+} /* packSample */
+
+
+static void packInt16(ALshort *dst, const ALfloat *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_CONVERT_SSE2
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    for (; (i + 8) <= samples; i += 8)
+    {
+        const __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        const __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+        const __m128i ia = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(a, hi), lo));
+        const __m128i ib = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(b, hi), lo));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi32(ia, ib));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+        dst[i] = (ALshort) packSample(src[i], 32768.0f);
+} /* packInt16 */
+
+
+static void packUint8(ALubyte *dst, const ALfloat *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_CONVERT_SSE2
+    const __m128 scale = _mm_set1_ps(128.0f);
+    const __m128 hi = _mm_set1_ps(127.0f);
+    const __m128 lo = _mm_set1_ps(-128.0f);
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; (i + 8) <= samples; i += 8)
+    {
+        const __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        const __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+        const __m128i ia = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(a, hi), lo));
+        const __m128i ib = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(b, hi), lo));
+        const __m128i w = _mm_add_epi16(_mm_packs_epi32(ia, ib), bias);
+        _mm_storel_epi64((__m128i *) (dst + i), _mm_packus_epi16(w, w));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+        dst[i] = (ALubyte) (packSample(src[i], 128.0f) + 128);
+} /* packUint8 */
+
+
+static ALfloat fraction(unsigned long long pos)
+{
+    /* the top 24 bits convert exactly, and never round up to 1.0f. */
+    return ((ALfloat) ((ALuint) (pos & 0xFFFFFFFF) >> 8)) *
+           (1.0f / 16777216.0f);
+} /* fraction */
+
+
+/* Catmull-Rom through p1 and p2; the SSE2 path does the same sums. */
+static ALfloat cubic(ALfloat p0, ALfloat p1, ALfloat p2, ALfloat p3,
+                     ALfloat t)
+{
+    const ALfloat a = ((p3 - p0) * 0.5f) + ((p1 - p2) * 1.5f);
+    const ALfloat b = (p0 - (p1 * 2.5f)) + ((p2 * 2.0f) - (p3 * 0.5f));
+    const ALfloat c = (p2 - p0) * 0.5f;
+    return (((((a * t) + b) * t) + c) * t) + p1;
+} /* cubic */
+
+
+/* Make as much output as the history allows, then trim the history. */
+static ALsizei resample(__alConverter *conv)
+{
+    const ALsizei ch = conv->dstChannels;
+    const ALfloat *history = conv->history;
+    const ALsizei limit = conv->historyFrames - 2;  /* need (i + 2). */
+    const unsigned long long step = conv->step;
+    unsigned long long pos = conv->position;
+    ALfloat *out = conv->output;
+    ALsizei produced = 0;
+    ALsizei drop;
+    ALsizei c;
+
+    #if __AL_CONVERT_SSE2
+    {
+        /* four lanes: four mono frames, or two stereo ones. */
+        const ALsizei group = 4 / ch;
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 onehalf = _mm_set1_ps(1.5f);
+        const __m128 twohalf = _mm_set1_ps(2.5f);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        while ((ALsizei) ((pos + ((group - 1) * step)) >> 32) < limit)
+        {
+            ALfloat p0[4], p1[4], p2[4], p3[4], t[4];
+            __m128 v0, v1, v2, v3, vt, a, b, cc;
+            ALsizei j;
+
+            for (j = 0; j < 4; j++)
+            {
+                const unsigned long long lanepos = pos + ((j / ch) * step);
+                const ALsizei frame = ((ALsizei) (lanepos >> 32)) - 1;
+                const ALfloat *p = history + ((frame * ch) + (j % ch));
+                p0[j] = p[0];
+                p1[j] = p[ch];
+                p2[j] = p[ch * 2];
+                p3[j] = p[ch * 3];
+                t[j] = fraction(lanepos);
+            } /* for */
+
+            v0 = _mm_loadu_ps(p0);
+            v1 = _mm_loadu_ps(p1);
+            v2 = _mm_loadu_ps(p2);
+            v3 = _mm_loadu_ps(p3);
+            vt = _mm_loadu_ps(t);
+            a = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v3, v0), half),
+                           _mm_mul_ps(_mm_sub_ps(v1, v2), onehalf));
+            b = _mm_add_ps(_mm_sub_ps(v0, _mm_mul_ps(v1, twohalf)),
+                           _mm_sub_ps(_mm_mul_ps(v2, two),
+                                      _mm_mul_ps(v3, half)));
+            cc = _mm_mul_ps(_mm_sub_ps(v2, v0), half);
+            a = _mm_add_ps(_mm_mul_ps(a, vt), b);
+            a = _mm_add_ps(_mm_mul_ps(a, vt), cc);
+            a = _mm_add_ps(_mm_mul_ps(a, vt), v1);
+            _mm_storeu_ps(out, a);
+
+            out += 4;
+            produced += group;
+            pos += group * step;
+        } /* while */
+    }
+    #endif
+
+    while ((ALsizei) (pos >> 32) < limit)
+    {
+        const ALfloat *p = history + ((((ALsizei) (pos >> 32)) - 1) * ch);
+        const ALfloat t = fraction(pos);
+        for (c = 0; c < ch; c++)
+        {
+            out[c] = cubic(p[c], p[ch + c], p[(ch * 2) + c],
+                           p[(ch * 3) + c], t);
+        } /* for */
+        out += ch;
+        produced++;
+        pos += step;
+    } /* while */
+
+    /* keep from one frame behind the next output on; that's at most three. */
+    drop = ((ALsizei) (pos >> 32)) - 1;
+    if (drop > conv->historyFrames)
+        drop = conv->historyFrames;  /* downsampling can skip past the end. */
+
+    if (drop > 0)
+    {
+        memmove(conv->history, conv->history + (drop * ch),
+                (conv->historyFrames - drop) * ch * sizeof (ALfloat));
+        conv->historyFrames -= drop;
+        pos -= ((unsigned long long) drop) << 32;
+    } /* if */
+
+    conv->position = pos;
+    return produced;
+} /* resample */
+
+
+ALdouble __alConverterOffset(const __alConverter *conv)
+{
+    /* (history)'s last frame comes just before the next input. */
+    if (conv->srcRate == conv->dstRate)
+        return 0.0;
+    return (((ALdouble) conv->position) / 4294967296.0) -
+           ((ALdouble) conv->historyFrames);
+} /* __alConverterOffset */
+
+
+ALsizei __alConverterRun(__alConverter *conv, const ALvoid *src,
+                         ALsizei frames, ALvoid *dst)
+{
+    const ALsizei dstSamples = conv->dstChannels;
+    const ALubyte *in = (const ALubyte *) src;
+    ALubyte *out = (ALubyte *) dst;
+    ALsizei retval = 0;
+
+    while (frames > 0)
+    {
+        const ALsizei count = (frames < CHUNK_FRAMES) ? frames : CHUNK_FRAMES;
+        ALsizei produced;
+
+        if (conv->srcRate == conv->dstRate)
+        {
+            expand(conv, in, count, conv->output);
+            produced = count;
+        } /* if */
+        else
+        {
+            expand(conv, in, count, conv->history +
+                                    (conv->historyFrames * dstSamples));
+            conv->historyFrames += count;
+            produced = resample(conv);
+        } /* else */
+
+        if ((conv->dstFormat == AL_FORMAT_MONO8) ||
+            (conv->dstFormat == AL_FORMAT_STEREO8))
+            packUint8(out, conv->output, produced * dstSamples);
+        else
+            packInt16((ALshort *) out, conv->output, produced * dstSamples);
+
+        in += count * conv->srcFrameSize;
+        out += produced * conv->dstFrameSize;
+        retval += produced;
+        frames -= count;
+    } /* while */
+
+    return retval;
+} /* __alConverterRun */
+
+/* end of alConvert.c ... */
@@ -0,0 +1,91 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALCONVERT_H_
+#define _INCL_ALCONVERT_H_
+
+#include "alCore.h"
+
+/*
+ * Streaming format conversion and resampling.
+ *
+ * A capture device doesn't have to give us what the application asked
+ *  for; open() says what it will really deliver, and the AL makes up the
+ *  difference on the way into the capture ring. A converter takes audio
+ *  in one of the AL formats at one rate and hands back another format at
+ *  another rate, one pump() at a time, carrying whatever state it needs
+ *  from one call to the next, so the output is seamless no matter how
+ *  the input is chopped up.
+ *
+ * Samples go through float in between: 8- and 16-bit input is expanded,
+ *  mono is copied to both sides or stereo averaged down, the result is
+ *  resampled, and it's packed back down with clamping. The conversions
+ *  use SSE2 when the compiler allows, and plain C otherwise, with the
+ *  same results either way.
+ *
+ * The resampler is a four-point Catmull-Rom cubic, which is plenty for a
+ *  microphone. It keeps the last few input frames between calls, so it
+ *  runs two frames behind its input; when the rates match, it's skipped
+ *  entirely and nothing is held back.
+ */
+
+typedef struct S_ALCONVERTER
+{
+    ALenum srcFormat;
+    ALsizei srcChannels;
+    ALsizei srcFrameSize;
+    ALuint srcRate;
+    ALenum dstFormat;
+    ALsizei dstChannels;
+    ALsizei dstFrameSize;
+    ALuint dstRate;
+
+    unsigned long long step;       /* input frames per output, 32.32. */
+    unsigned long long position;   /* next output, 32.32, into (history). */
+    ALfloat *history;        /* dstChannels floats per frame. */
+    ALsizei historyFrames;   /* frames in (history) now. */
+    ALfloat *output;         /* float output, before it's packed. */
+} __alConverter;
+
+/*
+ * Set up a converter from (srcFormat) at (srcRate) to (dstFormat) at
+ *  (dstRate). Returns AL_INVALID_ENUM if either format isn't one of the
+ *  four AL formats, AL_INVALID_VALUE for a zero rate, AL_OUT_OF_MEMORY,
+ *  or AL_NO_ERROR.
+ */
+ALenum __alConverterInit(__alConverter *conv, ALenum srcFormat,
+                         ALuint srcRate, ALenum dstFormat, ALuint dstRate);
+void __alConverterDeinit(__alConverter *conv);
+
+/*
+ * The most output frames __alConverterRun() can produce from (frames)
+ *  input frames.
+ */
+ALsizei __alConverterMaxOutput(const __alConverter *conv, ALsizei frames);
+
+/*
+ * Where the next output frame falls in the input, in input frames from
+ *  the first frame of the next __alConverterRun(); capture uses it to
+ *  carry timestamps across. It's usually negative, since the resampler
+ *  runs behind, but not always: when downsampling, the next output frame
+ *  may be a few input frames past the end of what's been seen so far (up
+ *  to +3 going from 48000Hz to 8000Hz, say).
+ */
+ALdouble __alConverterOffset(const __alConverter *conv);
+
+/*
+ * Convert (frames) input frames from (src), writing output to (dst), which
+ *  must have room for __alConverterMaxOutput(frames) of them. Returns how
+ *  many output frames were written.
+ */
+ALsizei __alConverterRun(__alConverter *conv, const ALvoid *src,
+                         ALsizei frames, ALvoid *dst);
+
+#endif
+
+/* end of alConvert.h ... */
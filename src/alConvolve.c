@@ -0,0 +1,315 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alConvolve.h"
+
+static void freeTierBuffers(__alConvolveTier *tier)
+{
+    __alFFTDeinit(&tier->fft);
+    free(tier->spectraRe);
+    free(tier->spectraIm);
+    free(tier->fdlRe);
+    free(tier->fdlIm);
+    free(tier->history);
+    free(tier->workRe);
+    free(tier->workIm);
+    free(tier->input);
+    free(tier->pending);
+    free(tier->ring);
+    __alSemaphoreDestroy(tier->jobReady);
+    __alSemaphoreDestroy(tier->jobDone);
+    memset(tier, '\0', sizeof (*tier));
+} /* freeTierBuffers */
+
+
+/*
+ * Set up a tier with (blockSize) partitions of IR frames [start, end).
+ *  Returns non-zero on success.
+ */
+static int initTier(__alConvolveTier *tier, const ALfloat *ir,
+                    ALsizei channels, ALsizei blockSize,
+                    ALsizei start, ALsizei end)
+{
+    const ALsizei fftsize = blockSize * 2;
+    const ALfloat scale = 1.0f / ((ALfloat) fftsize);
+    ALsizei bins, p, i;
+
+    tier->blockSize = blockSize;
+    tier->partitions = ((end - start) + (blockSize - 1)) / blockSize;
+    bins = tier->partitions * fftsize;
+
+    if (!__alFFTInit(&tier->fft, fftsize))
+        return 0;
+
+    tier->spectraRe = (ALfloat *) calloc(bins, sizeof (ALfloat));
+    tier->spectraIm = (ALfloat *) calloc(bins, sizeof (ALfloat));
+    tier->fdlRe = (ALfloat *) calloc(bins, sizeof (ALfloat));
+    tier->fdlIm = (ALfloat *) calloc(bins, sizeof (ALfloat));
+    tier->history = (ALfloat *) calloc(blockSize, sizeof (ALfloat));
+    tier->workRe = (ALfloat *) calloc(fftsize, sizeof (ALfloat));
+    tier->workIm = (ALfloat *) calloc(fftsize, sizeof (ALfloat));
+    tier->input = (ALfloat *) calloc(blockSize, sizeof (ALfloat));
+    if ((!tier->spectraRe) || (!tier->spectraIm) || (!tier->fdlRe) ||
+        (!tier->fdlIm) || (!tier->history) || (!tier->workRe) ||
+        (!tier->workIm) || (!tier->input))
+        return 0;
+
+    for (p = 0; p < tier->partitions; p++)
+    {
+        ALfloat *re = tier->spectraRe + (p * fftsize);
+        ALfloat *im = tier->spectraIm + (p * fftsize);
+        const ALsizei first = start + (p * blockSize);
+
+        /* first half is the partition (left + i*right), second is zeros. */
+        for (i = 0; (i < blockSize) && ((first + i) < end); i++)
+        {
+            const ALfloat *frame = ir + ((first + i) * channels);
+            re[i] = frame[0] * scale;
+            im[i] = frame[channels - 1] * scale;
+        } /* for */
+
+        __alFFTForward(&tier->fft, re, im);
+    } /* for */
+
+    return 1;
+} /* initTier */
+
+
+/*
+ * Push one block of input through a tier. On return, the second half of
+ *  workRe/workIm holds this block's output, left and right respectively.
+ */
+static void convolveBlock(__alConvolveTier *tier, const ALfloat *input)
+{
+    const ALsizei block = tier->blockSize;
+    const ALsizei fftsize = block * 2;
+    const ALsizei partitions = tier->partitions;
+    ALsizei slot, p;
+    ALfloat *re;
+    ALfloat *im;
+
+    slot = tier->fdlPos + 1;
+    if (slot >= partitions)
+        slot = 0;
+    tier->fdlPos = slot;
+
+    re = tier->fdlRe + (slot * fftsize);
+    im = tier->fdlIm + (slot * fftsize);
+    memcpy(re, tier->history, sizeof (ALfloat) * block);
+    memcpy(re + block, input, sizeof (ALfloat) * block);
+    memset(im, '\0', sizeof (ALfloat) * fftsize);
+    __alFFTForward(&tier->fft, re, im);
+    memcpy(tier->history, input, sizeof (ALfloat) * block);
+
+    memset(tier->workRe, '\0', sizeof (ALfloat) * fftsize);
+    memset(tier->workIm, '\0', sizeof (ALfloat) * fftsize);
+    for (p = 0; p < partitions; p++)
+    {
+        __alFFTMultiplyAccumulate(tier->workRe, tier->workIm,
+                                  tier->fdlRe + (slot * fftsize),
+                                  tier->fdlIm + (slot * fftsize),
+                                  tier->spectraRe + (p * fftsize),
+                                  tier->spectraIm + (p * fftsize), fftsize);
+        slot = (slot == 0) ? (partitions - 1) : (slot - 1);
+    } /* for */
+
+    __alFFTInverse(&tier->fft, tier->workRe, tier->workIm);
+} /* convolveBlock */
+
+
+static int tierThread(void *data)
+{
+    __alConvolveTier *tier = (__alConvolveTier *) data;
+    const ALsizei block = tier->blockSize;
+
+    while (1)
+    {
+        const ALfloat *re = tier->workRe + block;
+        const ALfloat *im = tier->workIm + block;
+        ALfloat *ring;
+        ALsizei i;
+
+        __alSemaphoreWait(tier->jobReady);
+        if (tier->quit)
+            break;
+
+        convolveBlock(tier, tier->input);
+
+        /* the mixer isn't reading this part of the ring right now. */
+        ring = tier->ring + (tier->jobTime * 2);
+        for (i = 0; i < block; i++)
+        {
+            *(ring++) = re[i];
+            *(ring++) = im[i];
+        } /* for */
+
+        __alSemaphorePost(tier->jobDone);
+    } /* while */
+
+    return 0;
+} /* tierThread */
+
+
+static int startWorker(__alConvolveTier *tier)
+{
+    const ALsizei block = tier->blockSize;
+
+    tier->pending = (ALfloat *) calloc(block, sizeof (ALfloat));
+    tier->ring = (ALfloat *) calloc(block * 2 * 2, sizeof (ALfloat));
+    tier->ringMask = (block * 2) - 1;
+    tier->jobReady = __alSemaphoreCreate(0);
+    tier->jobDone = __alSemaphoreCreate(0);
+    if ((!tier->pending) || (!tier->ring) || (!tier->jobReady) ||
+        (!tier->jobDone))
+        return 0;
+
+    tier->thread = __alThreadCreate(tierThread, tier);
+    return (tier->thread != NULL);
+} /* startWorker */
+
+
+__alConvolver *__alConvolverCreate(const ALfloat *ir, ALsizei frames,
+                                   ALsizei channels, ALsizei quantum)
+{
+    __alConvolver *conv;
+    ALsizei start = 0;
+    ALsizei block = quantum;
+    ALsizei i;
+
+    if ((frames <= 0) || (quantum <= 0) || ((quantum & (quantum - 1)) != 0))
+        return NULL;
+    else if ((channels != 1) && (channels != 2))
+        return NULL;
+
+    conv = (__alConvolver *) calloc(1, sizeof (__alConvolver));
+    if (conv == NULL)
+        return NULL;
+
+    conv->quantum = quantum;
+
+    /*
+     * Tier k covers [start, 2 * B_(k+1)), except the last one, which
+     *  covers whatever is left. Tier 0 starts at zero; every other tier
+     *  starts at exactly twice its own block size, which is what gives
+     *  its worker a whole block's worth of time to finish.
+     */
+    for (i = 0; (i < __AL_CONVOLVE_MAX_TIERS) && (start < frames); i++)
+    {
+        const ALsizei nextBlock = block * __AL_CONVOLVE_TIER_GROWTH;
+        ALsizei end = nextBlock * 2;
+        if ((end > frames) || (i == (__AL_CONVOLVE_MAX_TIERS - 1)))
+            end = frames;
+
+        conv->tierCount++;
+        if (!initTier(&conv->tiers[i], ir, channels, block, start, end))
+        {
+            __alConvolverDestroy(conv);
+            return NULL;
+        } /* if */
+
+        if ((i > 0) && (!startWorker(&conv->tiers[i])))
+        {
+            __alConvolverDestroy(conv);
+            return NULL;
+        } /* if */
+
+        start = end;
+        block = nextBlock;
+    } /* for */
+
+    return conv;
+} /* __alConvolverCreate */
+
+
+void __alConvolverDestroy(__alConvolver *conv)
+{
+    ALsizei i;
+
+    if (conv == NULL)
+        return;
+
+    for (i = 0; i < conv->tierCount; i++)
+    {
+        __alConvolveTier *tier = &conv->tiers[i];
+        if (tier->thread != NULL)
+        {
+            tier->quit = 1;
+            __alSemaphorePost(tier->jobReady);
+            __alThreadWait(tier->thread);
+        } /* if */
+        freeTierBuffers(tier);
+    } /* for */
+
+    free(conv);
+} /* __alConvolverDestroy */
+
+
+void __alConvolverProcess(__alConvolver *conv, const ALfloat *input,
+                          ALfloat *output)
+{
+    const ALsizei quantum = conv->quantum;
+    __alConvolveTier *tier = &conv->tiers[0];
+    ALsizei i, k;
+
+    /* the head of the IR, right here on the mixer thread. */
+    convolveBlock(tier, input);
+    for (i = 0; i < quantum; i++)
+    {
+        output[(i * 2) + 0] += tier->workRe[quantum + i];
+        output[(i * 2) + 1] += tier->workIm[quantum + i];
+    } /* for */
+
+    for (k = 1; k < conv->tierCount; k++)
+    {
+        const ALfloat *ring;
+        ALsizei block, pos;
+
+        tier = &conv->tiers[k];
+        block = tier->blockSize;
+
+        /* this was finished before the job after it was handed over. */
+        pos = (ALsizei) (conv->now & (ALuint) tier->ringMask);
+        ring = tier->ring + (pos * 2);
+        for (i = 0; i < (quantum * 2); i++)
+            output[i] += ring[i];
+
+        memcpy(tier->pending + tier->pendingFill, input,
+               sizeof (ALfloat) * quantum);
+        tier->pendingFill += quantum;
+        if (tier->pendingFill < block)
+            continue;
+
+        /*
+         * A full block of input. The last job's output starts playing
+         *  next quantum, so it had better be done by now.
+         */
+        if (tier->jobRunning)
+        {
+            if (!__alSemaphoreTryWait(tier->jobDone))
+            {
+                conv->missedDeadlines++;
+                __alSemaphoreWait(tier->jobDone);
+            } /* if */
+        } /* if */
+
+        memcpy(tier->input, tier->pending, sizeof (ALfloat) * block);
+        tier->pendingFill = 0;
+        tier->jobTime = (ALsizei) ((conv->now + quantum + block) &
+                                   (ALuint) tier->ringMask);
+        tier->jobRunning = AL_TRUE;
+        __alSemaphorePost(tier->jobReady);
+    } /* for */
+
+    conv->now += quantum;
+} /* __alConvolverProcess */
+
+/* end of alConvolve.c ... */
@@ -0,0 +1,111 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALCONVOLVE_H_
+#define _INCL_ALCONVOLVE_H_
+
+#include "alCore.h"
+#include "alFFT.h"
+#include "alThread.h"
+
+/*
+ * Impulse response ("convolution") reverb for effect slots running
+ *  AL_EFFECT_CONVOLUTION_SOFT. Like the other slot effects, this runs once
+ *  per slot per quantum over the summed input of every source sent to it.
+ *
+ * Multi-second impulse responses are far too long for the uniformly
+ *  partitioned scheme the HRTF code uses: with quantum-sized partitions,
+ *  a five second IR at 48kHz is close to a thousand spectrum
+ *  multiply-accumulates per quantum. Big partitions are cheap per sample
+ *  but need a big block of input before they can start, which is latency
+ *  we can't have. So we partition non-uniformly, in tiers:
+ *
+ *  - Tier 0 uses quantum-sized partitions (B) for the head of the IR, and
+ *    runs on the mixer thread. It has no latency beyond the quantum.
+ *  - Tier k > 0 uses partitions of B_k = B * 8^k, covering the IR from
+ *    2*B_k up to where the next tier takes over, and runs on its own
+ *    worker thread.
+ *
+ * A worker tier gets a job every B_k samples of input. Because its piece
+ *  of the IR doesn't start until 2*B_k, the first output of that job isn't
+ *  audible until B_k samples after the job is handed over; that is the
+ *  required lookahead, and it's all the time the worker has. The mixer
+ *  checks that the previous job is finished before handing over the next
+ *  one (which is also when the previous job's output is about to be
+ *  needed). If it isn't, the mixer has to block; that's a missed
+ *  deadline, and is counted so it can be reported.
+ *
+ * Stereo impulse responses are packed left + i*right into one complex
+ *  spectrum, like HRTF does, so stereo costs the same as mono.
+ */
+
+#define __AL_CONVOLVE_MAX_TIERS 3
+#define __AL_CONVOLVE_TIER_GROWTH 8
+
+typedef struct S_ALCONVTIER
+{
+    ALsizei blockSize;       /* B_k */
+    ALsizei partitions;
+    __alFFT fft;             /* 2 * B_k points. */
+    ALfloat *spectraRe;      /* (partitions * 2B_k) packed IR bins. */
+    ALfloat *spectraIm;
+    ALfloat *fdlRe;          /* (partitions * 2B_k) input spectra. */
+    ALfloat *fdlIm;
+    ALsizei fdlPos;
+    ALfloat *history;        /* previous input block (B_k samples). */
+    ALfloat *workRe;         /* (2B_k) work space. */
+    ALfloat *workIm;
+    ALfloat *input;          /* the block being convolved (B_k samples). */
+
+    /* worker tiers only. */
+    ALfloat *pending;        /* mixer-side input collection (B_k). */
+    ALsizei pendingFill;
+    ALfloat *ring;           /* (2B_k) stereo output frames, by time. */
+    ALsizei ringMask;
+    ALsizei jobTime;         /* ring frame where the job's output goes. */
+    ALboolean jobRunning;
+    volatile int quit;
+    __alSemaphore *jobReady;
+    __alSemaphore *jobDone;
+    __alThread *thread;
+} __alConvolveTier;
+
+typedef struct S_ALCONVOLVER
+{
+    ALsizei quantum;
+    ALsizei tierCount;
+    ALuint now;              /* samples processed so far (wraps). */
+    ALuint missedDeadlines;  /* times the mixer had to wait on a worker. */
+    __alConvolveTier tiers[__AL_CONVOLVE_MAX_TIERS];
+} __alConvolver;
+
+/*
+ * Build a convolver for (frames) sample frames of impulse response in
+ *  (ir), which is (channels) interleaved channels (1 or 2). The mixer will
+ *  feed it (quantum) samples at a time; (quantum) must be a power of two.
+ *  Worker threads are started here. Returns NULL on failure.
+ *
+ * This allocates and does a lot of FFTs, so call it from
+ *  commitEffectSlot(), never from rendering.
+ */
+__alConvolver *__alConvolverCreate(const ALfloat *ir, ALsizei frames,
+                                   ALsizei channels, ALsizei quantum);
+
+/* Stop the workers and free everything. */
+void __alConvolverDestroy(__alConvolver *conv);
+
+/*
+ * Convolve one quantum of mono (input), adding the result to (output),
+ *  which is (quantum) interleaved stereo frames.
+ */
+void __alConvolverProcess(__alConvolver *conv, const ALfloat *input,
+                          ALfloat *output);
+
+#endif
+
+/* end of alConvolve.h ... */
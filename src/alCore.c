@@ -1,12 +1,546 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "al.h"
+#include "alc.h"
+#include "alCore.h"
+#include "alAdpcm.h"
+#include "alSample.h"
+#include "alStream.h"
+#include "alThread.h"
+#include "alWorker.h"
 
-
-
+/* async uploads rarely wait in line; this is plenty. */
+#define UPLOAD_QUEUE_SIZE 256
 
 void __alContextUpkeep(void)
 {
     
 } /* __alContextUpkeep */
 
-/* end of alCore.c ... */
 
+ALenum __alBusSetParent(__alBus *bus, __alBus *parent)
+{
+    const __alBus *i;
+
+    for (i = parent; i != NULL; i = i->parent)
+    {
+        if (i == bus)
+            return AL_INVALID_OPERATION;  /* would loop forever. */
+    } /* for */
+
+    bus->parent = parent;
+    return AL_NO_ERROR;
+} /* __alBusSetParent */
+
+
+ALsizei __alBusDepth(const __alBus *bus)
+{
+    ALsizei retval = 0;
+    for (; bus != NULL; bus = bus->parent)
+        retval++;
+    return retval;
+} /* __alBusDepth */
+
+
+ALsizei __alFormatFrameSize(ALenum fmt)
+{
+    switch (fmt)
+    {
+        case AL_FORMAT_MONO8: return 1;
+        case AL_FORMAT_MONO16: return 2;
+        case AL_FORMAT_STEREO8: return 2;
+        case AL_FORMAT_STEREO16: return 4;
+    } /* switch */
+
+    return 0;
+} /* __alFormatFrameSize */
+
+
+ALenum __alBufferBlockAlignment(__alBuffer *buf, ALsizei frames)
+{
+    if (frames < 0)
+        return AL_INVALID_VALUE;
+    buf->blockAlign = frames;
+    return AL_NO_ERROR;
+} /* __alBufferBlockAlignment */
+
+
+ALenum __alBufferStorage(__alBuffer *buf, ALenum storage)
+{
+    if ((storage != AL_NONE) && (storage != AL_STORAGE_IMA4_IOAL) &&
+        (__alSampleSize(storage) == 0))
+        return AL_INVALID_VALUE;
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+
+    buf->storage = storage;
+    return AL_NO_ERROR;
+} /* __alBufferStorage */
+
+
+/*
+ * Called when (buf) gets new data of any kind. If it was a view, it lets
+ *  go of its parent. The count is atomic, since an async upload finishing
+ *  on a worker thread lands here too.
+ */
+static void detachView(__alBuffer *buf)
+{
+    if (buf->viewOf != NULL)
+    {
+        __alAtomicSub(&buf->viewOf->viewCount, 1);
+        buf->viewOf = NULL;
+        buf->viewOffset = 0;
+    } /* if */
+} /* detachView */
+
+
+/*
+ * Called when (buf) has been given new data of any kind. If it was a
+ *  stream, the device has let go of it, so it can be closed.
+ */
+static void closeStream(__alBuffer *buf)
+{
+    if (buf->stream != NULL)
+    {
+        __alStreamClose(buf->stream);
+        buf->stream = NULL;
+    } /* if */
+} /* closeStream */
+
+
+/*
+ * The checks alBufferDataStatic() and alBufferDataAsyncIOAL() share. On
+ *  success, (*blockAlign) is the bytes per block of (fmt) as (buf)
+ *  unpacks it (a PCM block is one sample frame), and (*frames) is how
+ *  many sample frames (size) bytes hold.
+ */
+static ALenum checkUpload(const __alBuffer *buf, ALenum fmt,
+                          const ALvoid *data, ALsizei size, ALsizei freq,
+                          ALsizei *blockAlign, ALsizei *frames)
+{
+    ALsizei align = __alFormatFrameSize(fmt);
+    ALsizei blockFrames = 1;
+
+    if (align == 0)  /* not PCM; ADPCM, maybe? */
+    {
+        if (__alAdpcmBlockFrames(fmt, 0) == 0)
+            return AL_INVALID_ENUM;
+        align = __alAdpcmBlockAlign(fmt, buf->blockAlign);
+        if (align == 0)
+            return AL_INVALID_VALUE;  /* it can't have blocks that size. */
+        blockFrames = __alAdpcmBlockFrames(fmt, align);
+    } /* if */
+
+    if ((data == NULL) || (size < 0) || ((size % align) != 0))
+        return AL_INVALID_VALUE;
+    else if ((size / align) > (INT_MAX / blockFrames))
+        return AL_INVALID_VALUE;  /* more frames than we can count. */
+    else if (freq <= 0)
+        return AL_INVALID_VALUE;
+    else if (__alAtomicLoad(&buf->viewCount) > 0)
+        return AL_INVALID_OPERATION;  /* views are using the old data. */
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+
+    *blockAlign = align;
+    *frames = (size / align) * blockFrames;
+    return AL_NO_ERROR;
+} /* checkUpload */
+
+
+ALenum __alBufferDataStatic(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                            const ALvoid *data, ALsizei size, ALsizei freq)
+{
+    const __alDeviceInterface *iface = dev->interface;
+    ALboolean referenced = AL_FALSE;
+    ALsizei blockAlign = 0;
+    ALsizei frames = 0;
+    ALenum rc;
+
+    rc = checkUpload(buf, fmt, data, size, freq, &blockAlign, &frames);
+    if (rc != AL_NO_ERROR)
+        return rc;
+
+    if (iface->uploadBufferStatic != NULL)
+    {
+        rc = iface->uploadBufferStatic(dev->impl, buf->impl, fmt, data,
+                                       size, freq, blockAlign, buf->storage,
+                                       &referenced);
+    } /* if */
+    else  /* the device always copies; that's still correct. */
+    {
+        rc = iface->uploadBuffer(dev->impl, buf->impl, fmt, (ALvoid *) data,
+                                 size, freq, blockAlign, buf->storage);
+    } /* else */
+
+    if (rc == AL_NO_ERROR)
+    {
+        buf->format = fmt;
+        buf->frames = frames;
+        buf->callback = NULL;
+        buf->callbackUserptr = NULL;
+        buf->staticData = referenced ? data : NULL;  /* else it's a copy. */
+        detachView(buf);
+        closeStream(buf);
+    } /* if */
+
+    return rc;
+} /* __alBufferDataStatic */
+
+
+/* an alBufferDataAsyncIOAL() in progress. */
+typedef struct S_ALUPLOADJOB
+{
+    __alJob job;
+    __alDevice *dev;
+    __alBuffer *buf;
+    ALenum fmt;
+    ALvoid *data;
+    ALsizei size;
+    ALsizei freq;
+    ALsizei blockAlign;  /* bytes; as the buffer was set when we queued. */
+    ALsizei frames;
+    ALenum storage;
+    ALboolean ownsData;  /* else (data) is our copy, right after this. */
+    __alFence *fence;
+} __alUploadJob;
+
+
+static void runUpload(__alJob *job)
+{
+    __alUploadJob *upload = (__alUploadJob *) job;
+    __alDevice *dev = upload->dev;
+    __alBuffer *buf = upload->buf;
+    __alFence *fence = upload->fence;
+    ALenum rc;
+
+    rc = dev->interface->uploadBuffer(dev->impl, buf->impl, upload->fmt,
+                                      upload->data, upload->size,
+                                      upload->freq, upload->blockAlign,
+                                      upload->storage);
+    if (rc == AL_NO_ERROR)
+    {
+        buf->format = upload->fmt;
+        buf->frames = upload->frames;
+        buf->callback = NULL;
+        buf->callbackUserptr = NULL;
+        buf->staticData = NULL;
+        detachView(buf);
+        closeStream(buf);
+    } /* if */
+
+    if (upload->ownsData)
+        free(upload->data);
+    free(upload);
+
+    /* this publishes the fields above to whoever sees the buffer idle. */
+    __alAtomicStore(&buf->uploading, 0);
+    if (fence != NULL)
+        __alFenceSignal(fence, rc);
+} /* runUpload */
+
+
+__alWorkerPool *__alDeviceWorkers(__alDevice *dev)
+{
+    __alWorkerPool *pool = __alAtomicLoad(&dev->workers);
+    __alWorkerPool *expected = NULL;
+
+    if (pool != NULL)
+        return pool;
+
+    pool = (__alWorkerPool *) malloc(sizeof (__alWorkerPool));
+    if (pool == NULL)
+        return NULL;
+    else if (!__alWorkerPoolInit(pool, 0, UPLOAD_QUEUE_SIZE))
+    {
+        free(pool);
+        return NULL;
+    } /* else if */
+
+    /* two threads got here at once? Use theirs. */
+    if (!__alAtomicCAS(&dev->workers, &expected, pool))
+    {
+        __alWorkerPoolDeinit(pool);
+        free(pool);
+        pool = expected;
+    } /* if */
+
+    return pool;
+} /* __alDeviceWorkers */
+
+
+ALenum __alBufferDataAsync(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                           ALvoid *data, ALsizei size, ALsizei freq,
+                           ALboolean owned, __alFence *fence)
+{
+    __alWorkerPool *pool;
+    __alUploadJob *upload;
+    ALsizei blockAlign = 0;
+    ALsizei frames = 0;
+    ALenum rc;
+
+    rc = checkUpload(buf, fmt, data, size, freq, &blockAlign, &frames);
+    if (rc != AL_NO_ERROR)
+        return rc;
+
+    if (owned)
+        upload = (__alUploadJob *) malloc(sizeof (__alUploadJob));
+    else  /* one allocation for the job and the copy. */
+    {
+        upload = (__alUploadJob *) malloc(sizeof (__alUploadJob) + size);
+        if (upload != NULL)
+        {
+            memcpy(upload + 1, data, size);
+            data = (ALvoid *) (upload + 1);
+        } /* if */
+    } /* else */
+
+    if (upload == NULL)
+        return AL_OUT_OF_MEMORY;
+
+    upload->job.run = runUpload;
+    upload->dev = dev;
+    upload->buf = buf;
+    upload->fmt = fmt;
+    upload->data = data;
+    upload->size = size;
+    upload->freq = freq;
+    upload->blockAlign = blockAlign;
+    upload->frames = frames;
+    upload->storage = buf->storage;
+    upload->ownsData = owned;
+    upload->fence = fence;
+
+    /* if it's a view, its parent stays pinned until this succeeds. */
+    __alAtomicStore(&buf->uploading, 1);
+    if (fence != NULL)
+        __alFenceArm(fence, 1);
+
+    pool = __alDeviceWorkers(dev);
+    if (pool != NULL)
+        __alWorkerPoolSubmit(pool, &upload->job);
+    else  /* no threads to be had; better late than never. */
+        runUpload(&upload->job);
+
+    return AL_NO_ERROR;
+} /* __alBufferDataAsync */
+
+
+void __alBufferWaitUpload(__alBuffer *buf)
+{
+    /* only alDeleteBuffers() waits on this, so polling is fine. */
+    while (__alAtomicLoad(&buf->uploading))
+        __alThreadSleep(1);
+} /* __alBufferWaitUpload */
+
+
+void __alDeviceStopWorkers(__alDevice *dev)
+{
+    __alWorkerPool *pool = __alAtomicExchange(&dev->workers, NULL);
+    if (pool != NULL)
+    {
+        __alWorkerPoolDeinit(pool);
+        free(pool);
+    } /* if */
+} /* __alDeviceStopWorkers */
+
+
+ALenum __alBufferCallbackSOFT(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                              ALsizei freq, __alBufferCallback callback,
+                              ALvoid *userptr)
+{
+    ALenum rc;
+
+    if (__alFormatFrameSize(fmt) == 0)
+        return AL_INVALID_ENUM;
+    else if ((callback == NULL) || (freq <= 0))
+        return AL_INVALID_VALUE;
+    else if (dev->interface->setBufferCallback == NULL)
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&buf->viewCount) > 0)
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+
+    rc = dev->interface->setBufferCallback(dev->impl, buf->impl, fmt, freq,
+                                           callback, userptr);
+    if (rc == AL_NO_ERROR)
+    {
+        buf->format = fmt;
+        buf->frames = 0;  /* there's no end to find. */
+        buf->staticData = NULL;
+        buf->callback = callback;
+        buf->callbackUserptr = userptr;
+        detachView(buf);
+        closeStream(buf);
+    } /* if */
+
+    return rc;
+} /* __alBufferCallbackSOFT */
+
+
+ALenum __alBufferStream(__alDevice *dev, __alBuffer *buf, const char *path,
+                        ALenum fmt, ALsizei freq,
+                        unsigned long long dataOffset,
+                        unsigned long long dataSize,
+                        ALsizei window, ALsizei chunk, ALboolean loop)
+{
+    const ALsizei framesize = __alFormatFrameSize(fmt);
+    __alStream *stream;
+    ALenum rc;
+
+    if (framesize == 0)
+        return AL_INVALID_ENUM;
+    else if ((path == NULL) || (freq <= 0))
+        return AL_INVALID_VALUE;
+    else if (dev->interface->setBufferStream == NULL)
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&buf->viewCount) > 0)
+        return AL_INVALID_OPERATION;  /* views are using the old data. */
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+
+    stream = __alStreamOpen(path, fmt, freq, dataOffset, dataSize,
+                            window, chunk, loop);
+    if (stream == NULL)
+        return AL_INVALID_VALUE;
+
+    rc = dev->interface->setBufferStream(dev->impl, buf->impl, stream);
+    if (rc != AL_NO_ERROR)
+    {
+        __alStreamClose(stream);
+        return rc;
+    } /* if */
+
+    detachView(buf);
+    closeStream(buf);  /* the old one, if it was a stream already. */
+    buf->format = fmt;
+    buf->frames = (ALsizei) ((stream->dataEnd - stream->dataStart) /
+                             framesize);
+    buf->callback = NULL;
+    buf->callbackUserptr = NULL;
+    buf->staticData = NULL;
+    buf->stream = stream;
+    return AL_NO_ERROR;
+} /* __alBufferStream */
+
+
+ALenum __alBufferSubData(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                         const ALvoid *data, ALsizei offset, ALsizei length)
+{
+    __alBuffer *target = buf;
+    ALsizei framesize;
+
+    /*
+     * An async upload writes the buffer's fields from a worker thread, so
+     *  don't look at any of them until we know there isn't one.
+     */
+    if (dev->interface->updateBuffer == NULL)
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+
+    framesize = __alFormatFrameSize(buf->format);
+    if ((buf->callback != NULL) || (buf->stream != NULL))
+        return AL_INVALID_OPERATION;
+    else if (fmt != buf->format)
+        return AL_INVALID_ENUM;
+    else if ((framesize == 0) || (data == NULL))
+        return AL_INVALID_VALUE;
+    else if ((offset < 0) || (length < 0))
+        return AL_INVALID_VALUE;
+    else if (((offset % framesize) != 0) || ((length % framesize) != 0))
+        return AL_INVALID_VALUE;
+    else if ((offset / framesize) > buf->frames)
+        return AL_INVALID_VALUE;
+    else if ((length / framesize) > (buf->frames - (offset / framesize)))
+        return AL_INVALID_VALUE;
+
+    /* a view writes through to its parent's storage. */
+    if (buf->viewOf != NULL)
+    {
+        target = buf->viewOf;
+        offset += buf->viewOffset * framesize;
+    } /* if */
+
+    /* the application owns static data; it can write there itself. */
+    if (target->staticData != NULL)
+        return AL_INVALID_OPERATION;
+    else if (length == 0)
+        return AL_NO_ERROR;
+
+    return dev->interface->updateBuffer(dev->impl, target->impl, fmt, data,
+                                        offset, length);
+} /* __alBufferSubData */
+
+
+ALenum __alBufferView(__alDevice *dev, __alBuffer *buf, __alBuffer *parent,
+                      ALsizei offset, ALsizei frames)
+{
+    ALenum rc;
+
+    /* as in __alBufferSubData(), check for uploads before reading fields. */
+    if (dev->interface->setBufferView == NULL)
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&buf->uploading))
+        return AL_INVALID_OPERATION;
+    else if (__alAtomicLoad(&parent->uploading))
+        return AL_INVALID_OPERATION;
+    else if ((parent == buf) || (__alAtomicLoad(&buf->viewCount) > 0))
+        return AL_INVALID_OPERATION;
+    else if ((parent->callback != NULL) || (parent->stream != NULL))
+        return AL_INVALID_OPERATION;
+    else if ((offset < 0) || (frames <= 0) || (offset > parent->frames))
+        return AL_INVALID_VALUE;
+    else if (frames > (parent->frames - offset))
+        return AL_INVALID_VALUE;
+
+    /* views of views are flattened, so the device only sees real data. */
+    if (parent->viewOf != NULL)
+    {
+        offset += parent->viewOffset;
+        parent = parent->viewOf;
+    } /* if */
+
+    rc = dev->interface->setBufferView(dev->impl, buf->impl, parent->impl,
+                                       offset, frames);
+    if (rc == AL_NO_ERROR)
+    {
+        detachView(buf);
+        closeStream(buf);
+        buf->format = parent->format;
+        buf->frames = frames;
+        buf->callback = NULL;
+        buf->callbackUserptr = NULL;
+        buf->staticData = NULL;
+        buf->viewOf = parent;
+        buf->viewOffset = offset;
+        __alAtomicAdd(&parent->viewCount, 1);
+    } /* if */
+
+    return rc;
+} /* __alBufferView */
+
+
+ALboolean __alBufferCallbackPull(const __alBuffer *buf, ALvoid *dst,
+                                 ALsizei bytes)
+{
+    ALsizei got = buf->callback(buf->callbackUserptr, dst, bytes);
+    int silence = 0x00;
+
+    if (got >= bytes)
+        return AL_TRUE;
+    else if (got < 0)
+        got = 0;
+
+    /* 8-bit is unsigned; zero there is a full-scale click. */
+    if ((buf->format == AL_FORMAT_MONO8) || (buf->format == AL_FORMAT_STEREO8))
+        silence = 0x80;
+
+    memset(((ALubyte *) dst) + got, silence, bytes - got);
+    return AL_FALSE;
+} /* __alBufferCallbackPull */
+
+/* end of alCore.c ... */
@@ -67,6 +67,162 @@ typedef struct S_ALCAPIMPL
     void *opaque;
 } __alCaptureImpl;
 
+typedef struct S_ALSLOTIMPL
+{
+    void *opaque;
+} __alEffectSlotImpl;
+
+typedef struct S_ALBUSIMPL
+{
+    void *opaque;
+} __alBusImpl;
+
+
+/* EFX effect types we know about, if the headers didn't provide them. */
+#ifndef AL_EFFECT_NULL
+#define AL_EFFECT_NULL 0x0000
+#endif
+#ifndef AL_EFFECT_REVERB
+#define AL_EFFECT_REVERB 0x0001
+#endif
+#ifndef AL_EFFECT_CONVOLUTION_SOFT
+#define AL_EFFECT_CONVOLUTION_SOFT 0xA000
+#endif
+
+/* EFX filter types we know about, if the headers didn't provide them. */
+#ifndef AL_FILTER_NULL
+#define AL_FILTER_NULL 0x0000
+#endif
+#ifndef AL_FILTER_LOWPASS
+#define AL_FILTER_LOWPASS 0x0001
+#endif
+#ifndef AL_FILTER_HIGHPASS
+#define AL_FILTER_HIGHPASS 0x0002
+#endif
+#ifndef AL_FILTER_BANDPASS
+#define AL_FILTER_BANDPASS 0x0003
+#endif
+
+/* ADPCM formats we know about, if the headers didn't provide them. */
+#ifndef AL_FORMAT_MONO_IMA4
+#define AL_FORMAT_MONO_IMA4 0x1300
+#endif
+#ifndef AL_FORMAT_STEREO_IMA4
+#define AL_FORMAT_STEREO_IMA4 0x1301
+#endif
+#ifndef AL_FORMAT_MONO_MSADPCM_SOFT
+#define AL_FORMAT_MONO_MSADPCM_SOFT 0x1302
+#endif
+#ifndef AL_FORMAT_STEREO_MSADPCM_SOFT
+#define AL_FORMAT_STEREO_MSADPCM_SOFT 0x1303
+#endif
+
+/* AL_SOFT_block_alignment: sample frames per ADPCM block, for uploads. */
+#ifndef AL_UNPACK_BLOCK_ALIGNMENT_SOFT
+#define AL_UNPACK_BLOCK_ALIGNMENT_SOFT 0x200C
+#endif
+
+/*
+ * Buffer property: how the software mixer keeps a buffer's samples; see
+ *  alSample.h. AL_NONE lets the device choose. AL_STORAGE_IMA4_IOAL asks
+ *  for 16-bit uploads to be kept compressed (see uploadBuffer()); that
+ *  one is a hint, and devices may ignore it.
+ */
+#ifndef AL_BUFFER_STORAGE_IOAL
+#define AL_BUFFER_STORAGE_IOAL 0x19A1
+#define AL_STORAGE_FLOAT32_IOAL 0x19A2
+#define AL_STORAGE_INT16_IOAL 0x19A3
+#define AL_STORAGE_FLOAT16_IOAL 0x19A4
+#define AL_STORAGE_INT24_IOAL 0x19A5
+#define AL_STORAGE_IMA4_IOAL 0x19A6
+#endif
+
+/* Number of auxiliary sends per source (ALC_MAX_AUXILIARY_SENDS). */
+#define __AL_MAX_SOURCE_SENDS 4
+
+/* Readers per capture device, alcCaptureSamples()'s included. */
+#define __AL_MAX_CAPTURE_READERS 8
+
+
+/*
+ * Standard (EFX-style) reverb properties. Units and ranges match EFX.
+ */
+typedef struct S_ALREVERBPROPS
+{
+    ALfloat density;             /* 0.0 to 1.0 */
+    ALfloat diffusion;           /* 0.0 to 1.0 */
+    ALfloat gain;                /* 0.0 to 1.0 */
+    ALfloat gainHF;              /* 0.0 to 1.0, at 5kHz */
+    ALfloat decayTime;           /* 0.1 to 20.0 seconds */
+    ALfloat decayHFRatio;        /* 0.1 to 2.0 */
+    ALfloat reflectionsGain;     /* 0.0 to 3.16 */
+    ALfloat reflectionsDelay;    /* 0.0 to 0.3 seconds */
+    ALfloat lateReverbGain;      /* 0.0 to 10.0 */
+    ALfloat lateReverbDelay;     /* 0.0 to 0.1 seconds */
+    ALfloat airAbsorptionGainHF; /* 0.892 to 1.0 */
+    ALfloat roomRolloffFactor;   /* 0.0 to 10.0 */
+    ALboolean decayHFLimit;
+} __alReverbProperties;
+
+
+/*
+ * An EFX-style filter, as attached to a source's direct path or sends.
+ *  Filter objects are copied into the source when attached, like EFX
+ *  specifies, so this is plain data. gainHF is at 5kHz, gainLF at 250Hz.
+ */
+typedef struct S_ALFILTERSTATE
+{
+    ALenum type;                 /* AL_FILTER_NULL, AL_FILTER_LOWPASS... */
+    ALfloat gain;
+    ALfloat gainHF;              /* lowpass and bandpass */
+    ALfloat gainLF;              /* highpass and bandpass */
+} __alFilterState;
+
+
+/*
+ * Auxiliary effect slot state. Sources feed a slot through one of their
+ *  sends; the slot runs its effect once over the sum of everything sent
+ *  to it, so an effect costs the same no matter how many sources use it.
+ */
+typedef struct S_ALEFFECTSLOT
+{
+    ALenum effectType;           /* AL_EFFECT_NULL, AL_EFFECT_REVERB... */
+    ALfloat gain;                /* AL_EFFECTSLOT_GAIN */
+    __alReverbProperties reverb; /* valid if effectType is a reverb. */
+    struct S_ALBUF *impulseResponse;  /* for AL_EFFECT_CONVOLUTION_SOFT. */
+    __alEffectSlotImpl *impl;
+} __alEffectSlot;
+
+
+/* One of a source's auxiliary sends. */
+typedef struct S_ALSRCSEND
+{
+    __alEffectSlot *slot;        /* NULL if this send is disconnected. */
+    ALfloat gain;
+    __alFilterState filter;
+} __alSourceSend;
+
+
+/*
+ * Submix bus state. A bus is where a group of sources (or other buses)
+ *  mix before going on to the context's output: its gain, filter and
+ *  effect sends apply once to the sum of everything routed into it, not
+ *  once per source. That makes a bus the cheap way to change a whole
+ *  group at once; "duck all the music" is one bus gain change and one
+ *  commitBus(), no matter how many sources are playing music.
+ *
+ * Buses may route into other buses, but never in a loop; the AL core
+ *  makes sure of that (see __alBusSetParent()).
+ */
+typedef struct S_ALBUS
+{
+    ALfloat gain;
+    __alFilterState filter;
+    __alSourceSend sends[__AL_MAX_SOURCE_SENDS];
+    struct S_ALBUS *parent;      /* NULL to mix straight to the output. */
+    __alBusImpl *impl;
+} __alBus;
+
 
 /*
  * Source state.
@@ -74,16 +230,51 @@ typedef struct S_ALCAPIMPL
 typedef struct S_ALSRC
 {
     /* !!! FIXME: Fill in state here. */
+    __alBus *bus;                /* NULL to mix straight to the output. */
+    struct S_ALSRCQUEUE *queue;  /* buffer queue; see alQueue.h. */
+    __alFilterState directFilter;
+    __alSourceSend sends[__AL_MAX_SOURCE_SENDS];
     __alSourceImpl *impl;
 } __alSource;
 
 
+/*
+ * AL_SOFT_callback_buffer. The mixer calls this to fill (sampledata) with
+ *  up to (numbytes) bytes of audio in the buffer's format, and it returns
+ *  how many bytes it wrote. Returning less than (numbytes) means the sound
+ *  has ended; the source will stop once what it did get has played.
+ *
+ * THE REAL-TIME CONTRACT: this is called from the mixer thread, in the
+ *  middle of rendering, while the whole device waits for it. It must
+ *  return quickly and in bounded time. It must not block: no locks that
+ *  another thread might hold for long, no allocating memory, no file or
+ *  network i/o, and no calls back into the AL. It may be called for
+ *  several buffers from the same thread in one quantum, and (numbytes)
+ *  is always a whole number of sample frames. If the data isn't ready,
+ *  hand back silence rather than waiting for it.
+ */
+typedef ALsizei (*__alBufferCallback)(ALvoid *userptr, ALvoid *sampledata,
+                                      ALsizei numbytes);
+
+
 /*
  * Buffer state.
  */
 typedef struct S_ALBUF
 {
     /* !!! FIXME: Fill in state here. */
+    ALenum format;               /* as uploaded; AL_FORMAT_MONO16, etc. */
+    ALsizei frames;              /* sample frames of data, once uploaded. */
+    __alBufferCallback callback; /* non-NULL for callback buffers. */
+    ALvoid *callbackUserptr;
+    const ALvoid *staticData;    /* non-NULL if device may reference it. */
+    struct S_ALSTREAM *stream;   /* non-NULL for file streams; alStream.h */
+    ALenum storage;              /* AL_BUFFER_STORAGE_IOAL; AL_NONE default. */
+    ALsizei blockAlign;          /* AL_UNPACK_BLOCK_ALIGNMENT_SOFT; frames. */
+    struct S_ALBUF *viewOf;      /* non-NULL for views; see __alBufferView. */
+    ALsizei viewOffset;          /* first sample frame of the view. */
+    ALuint viewCount;            /* views of this; they pin it. atomic. */
+    ALuint uploading;            /* async upload in flight; atomic. */
     __alBufferImpl *impl;
 } __alBuffer;
 
@@ -94,6 +285,10 @@ typedef struct S_ALBUF
 typedef struct S_ALCTX
 {
     /* !!! FIXME: Fill in state here. */
+    ALuint effectSlotCount;
+    __alEffectSlot *effectSlots;
+    ALuint busCount;
+    __alBus *buses;
     __alContextImpl *impl;
 } __alContext;
 
@@ -256,11 +451,201 @@ typedef struct S_ALDEVINTERFACE
      *  advantageous to defer the real upload until the buffer is actually
      *  assigned to a source via AL_BUFFER or the buffer queueing mechanism.
      *
+     * (data) is (size) bytes. For PCM formats that's a whole number of
+     *  sample frames, and (blockAlign) is the frame size. For ADPCM
+     *  formats it's a whole number of blocks of (blockAlign) bytes, as
+     *  the buffer's AL_UNPACK_BLOCK_ALIGNMENT_SOFT asked; the AL has
+     *  checked that the format can have blocks that size. (storage) is
+     *  the buffer's AL_BUFFER_STORAGE_IOAL, a preference for how you keep
+     *  the samples, which you may ignore.
+     *
+     * You don't have to expand everything to the mixing format, either.
+     *  The software mixer keeps ADPCM formats as they are and decodes
+     *  them a block at a time while mixing, through a small per-voice
+     *  cache (__alAdpcmInit() takes (size) and (blockAlign) as they are);
+     *  if (storage) is AL_STORAGE_IMA4_IOAL, it also compresses 16-bit
+     *  uploads to IMA ADPCM here. That's about a quarter of the memory
+     *  for a little CPU. See alAdpcm.h.
+     *
+     * Otherwise, the software mixer stores samples the way (storage)
+     *  says (float32, int16, float16 or packed 24-bit; see alSample.h),
+     *  and converts to float as it mixes. With no preference it uses
+     *  float32 for buffers short enough that memory doesn't matter, and
+     *  int16 otherwise.
+     *  That storage is padded with a few guard frames at each end and a
+     *  copy of the loop seam (__alPaddedSamples, in alSample.h), so the
+     *  resampler can read past the ends without checking every sample.
+     *
+     * Big uploads don't have to convert on one core. The software mixer
+     *  hands the conversion (or ADPCM compression) to the device's
+     *  worker pool, __alDeviceWorkers(), a piece per core; see
+     *  __alSampleImportParallel() and __alAdpcmEncode(). The result is
+     *  the same as converting it all in one go.
+     *
+     * Identical uploads can share their converted samples, too. The
+     *  software mixer puts every upload through a per-device sample pool
+     *  (see alPool.h), so ten buffer names holding the same sound cost
+     *  one copy; it drops the buffer's reference in freeBuffer() and when
+     *  the buffer is given new data.
+     *
+     * This is also called for alBufferDataAsyncIOAL(), but from one of the
+     *  AL's worker threads (see alWorker.h), so the application isn't kept
+     *  waiting. The AL won't touch (buf) while that's going on, but other
+     *  calls into the device, uploads of other buffers included, may be
+     *  running on other threads at the same time. The software mixer only
+     *  shares the sample pool between buffers, and that has its own lock.
+     *
      * Returns an error code (AL_OUT_OF_MEMORY, etc) on failure, or
      *  AL_NO_ERROR on success.
      */
     ALenum (*uploadBuffer)(__alDeviceImpl *dev, __alBufferImpl *buf,
-                           ALenum fmt, ALvoid *data, ALsizei freq);
+                           ALenum fmt, ALvoid *data, ALsizei size,
+                           ALsizei freq, ALsizei blockAlign,
+                           ALenum storage);
+
+    /*
+     * Prepare a buffer for playback without copying. The AL calls this
+     *  from alBufferDataStatic(). This is uploadBuffer() with one
+     *  difference: the application promises that (data) will stay valid
+     *  and unchanged until the buffer is deleted or given new data, so
+     *  if (fmt) and (freq) are something you can mix from directly, you
+     *  may keep a pointer to (data) instead of copying it. For big sound
+     *  banks that are mapped into memory, this saves the copy and half the
+     *  resident memory.
+     *
+     * The software mixer references the data directly if it's already in
+     *  a format it can mix natively at the device's frequency (ADPCM
+     *  included, whatever (storage) says), and falls back to a normal
+     *  converted copy otherwise; the application can't tell the
+     *  difference either way.
+     *
+     * Set (*referenced) to AL_TRUE if you kept a pointer to (data), and
+     *  AL_FALSE if you made a copy after all. The AL uses that to decide
+     *  whether the buffer's samples still belong to the application (and
+     *  so can't be changed through alBufferSubDataSOFT()) or to you.
+     *
+     * This may be NULL, in which case the AL just calls uploadBuffer().
+     *
+     * Returns an error code (AL_OUT_OF_MEMORY, etc) on failure, or
+     *  AL_NO_ERROR on success.
+     */
+    ALenum (*uploadBufferStatic)(__alDeviceImpl *dev, __alBufferImpl *buf,
+                                 ALenum fmt, const ALvoid *data,
+                                 ALsizei size, ALsizei freq,
+                                 ALsizei blockAlign, ALenum storage,
+                                 ALboolean *referenced);
+
+    /*
+     * Make a buffer callback-driven. The AL calls this from
+     *  alBufferCallbackSOFT(). Instead of holding samples, the buffer pulls
+     *  (fmt) audio at (freq) from (callback) whenever the mixer needs more
+     *  for a source playing it; any data previously uploaded to the buffer
+     *  should be freed. Nothing is copied up front and nothing is queued,
+     *  which is the point: the application produces audio exactly as fast
+     *  as it's consumed. Please see the contract on __alBufferCallback.
+     *
+     * Convert as you pull: the software mixer reads the callback into a
+     *  small per-voice staging area and converts from there, so it doesn't
+     *  need a buffer-sized allocation at all.
+     *
+     * Callback buffers can only be attached with AL_BUFFER; they can't be
+     *  queued, since they never end on a known sample frame.
+     *
+     * This may be NULL if you can't support it; the extension won't be
+     *  advertised. Returns an error code (AL_OUT_OF_MEMORY, etc) on
+     *  failure, or AL_NO_ERROR on success.
+     */
+    ALenum (*setBufferCallback)(__alDeviceImpl *dev, __alBufferImpl *buf,
+                                ALenum fmt, ALsizei freq,
+                                __alBufferCallback callback, ALvoid *userptr);
+
+    /*
+     * Make a buffer stream from a file. The AL calls this from
+     *  alBufferStreamIOAL(), after it has opened (stream) and started its
+     *  read-ahead thread. Instead of holding samples, the buffer plays
+     *  whatever the stream has read, in the stream's format and frequency;
+     *  any data previously uploaded to the buffer should be freed. The AL
+     *  owns the stream, and closes it once the buffer has been given
+     *  something else, so just keep the pointer.
+     *
+     * The software mixer pulls from the stream in place with
+     *  __alStreamPeek() and __alStreamConsume() and converts as it mixes,
+     *  like it does for callback buffers; if the stream comes up empty,
+     *  the voice plays silence for that quantum rather than waiting. See
+     *  alStream.h.
+     *
+     * Stream buffers can only be attached with AL_BUFFER, not queued.
+     *
+     * This may be NULL if you can't support it; the extension won't be
+     *  advertised. Returns an error code (AL_OUT_OF_MEMORY, etc) on
+     *  failure, or AL_NO_ERROR on success.
+     */
+    ALenum (*setBufferStream)(__alDeviceImpl *dev, __alBufferImpl *buf,
+                              struct S_ALSTREAM *stream);
+
+    /*
+     * Overwrite part of a buffer's data in place. The AL calls this from
+     *  alBufferSubDataSOFT(). (data) is (length) bytes in (fmt), which
+     *  is the format the buffer was uploaded in, to be written starting
+     *  (offset) bytes into the buffer as it was uploaded. Both are whole
+     *  sample frames, and the range is already checked against the
+     *  buffer's size. Convert just that range into the storage you
+     *  already have; don't reallocate, and don't touch the rest. That's
+     *  what lets an application stream through a single looping buffer,
+     *  writing the half that isn't playing.
+     *
+     * The mixer may be playing the buffer while you write, and that's
+     *  the application's lookout: a range that's playing right now
+     *  might be heard half old and half new, but it must never be
+     *  garbage, so write samples whole (the software mixer's storage
+     *  formats are all naturally aligned, or bytes; see alSample.h).
+     *
+     * If the storage is shared with other buffers (see alPool.h), break
+     *  the share first with __alSamplePoolUnshare(), or every buffer
+     *  with the same sound changes. If the range is near either end of
+     *  padded storage, call __alPaddedFinish() after, so the loop seam
+     *  matches. If it's stored in a way that can't
+     *  be patched (the software mixer's ADPCM storage, for one), return
+     *  AL_INVALID_OPERATION.
+     *
+     * The AL doesn't call this for callback, stream or static buffers.
+     *  For a view, it's called on the parent, with (offset) moved into
+     *  the view's range.
+     *
+     * This may be NULL if you can't support it; the extension won't be
+     *  advertised. Returns an error code (AL_OUT_OF_MEMORY, etc) on
+     *  failure, or AL_NO_ERROR on success.
+     */
+    ALenum (*updateBuffer)(__alDeviceImpl *dev, __alBufferImpl *buf,
+                           ALenum fmt, const ALvoid *data, ALsizei offset,
+                           ALsizei length);
+
+    /*
+     * Make a buffer a view of another. The AL calls this from
+     *  alBufferViewIOAL(). Instead of holding samples, (buf) now plays
+     *  (frames) sample frames of (parent), starting at frame (offset);
+     *  any data previously uploaded to (buf) should be freed. It's
+     *  otherwise an ordinary buffer: it can be attached with AL_BUFFER
+     *  or queued, and it loops over its own range, not the parent's.
+     *
+     * This is how a sound atlas is split up: one upload for the whole
+     *  thing, then a view per sound, with no copies. Don't copy here
+     *  either; the software mixer just remembers (parent)'s storage and
+     *  the offset, so a voice playing a view reads the parent's samples
+     *  directly.
+     *
+     * The AL makes sure (parent) isn't deleted or given new data while
+     *  views of it exist, and that it's a plain buffer with samples (not
+     *  a callback or stream, and not a view itself: views of views are
+     *  flattened before you see them). The range is already checked.
+     *
+     * This may be NULL if you can't support it; the extension won't be
+     *  advertised. Returns an error code (AL_OUT_OF_MEMORY, etc) on
+     *  failure, or AL_NO_ERROR on success.
+     */
+    ALenum (*setBufferView)(__alDeviceImpl *dev, __alBufferImpl *buf,
+                            __alBufferImpl *parent, ALsizei offset,
+                            ALsizei frames);
 
     /*
      * This is called when preparing to process a context and a source's
@@ -277,6 +662,14 @@ typedef struct S_ALDEVINTERFACE
      *  they are likely to change or disappear between commits. If you need
      *  to store state information outside of the device, you will need to
      *  copy this structure.
+     *
+     * The one exception is the source's buffer queue, which is shared
+     *  with the mixer through lock-free queues and never waits for a
+     *  commit; see alQueue.h. Don't copy it, just keep the pointer.
+     *
+     * This is also the place to turn the source's direct and send filters
+     *  into coefficients; the software mixer does so here (see alFilter.h),
+     *  so rendering never has to.
      */
     void (*commitSource)(__alDeviceImpl *dev, const __alSource *src);
 
@@ -302,6 +695,75 @@ typedef struct S_ALDEVINTERFACE
      */
     void (*commitContext)(__alDeviceImpl *dev, const __alContext *ctx);
 
+    /*
+     * Allocate an auxiliary effect slot...The AL calls this from the
+     *  alGenAuxiliaryEffectSlots() entry point. Like sources, slots are a
+     *  finite resource, and repeated calls should eventually fail.
+     *
+     * The software mixer gives each slot a single input buffer per
+     *  quantum. Sources with a send connected to the slot add their
+     *  (already filtered) output into that buffer, scaled by the send gain,
+     *  which is the only per-source cost of an effect. The effect itself
+     *  then runs once per slot per quantum over the summed input; see
+     *  alReverb.h for the reverb and alConvolve.h for convolution.
+     *
+     * If you can allocate another slot on the device, return a pointer
+     *  to instance data for this slot. Otherwise, return NULL.
+     */
+    __alEffectSlotImpl *(*allocateEffectSlot)(__alDeviceImpl *dev,
+                                              __alContextImpl *ctx);
+
+    /*
+     * Free a previously allocated slot. This is called from
+     *  alDeleteAuxiliaryEffectSlots. No source sends will reference the
+     *  slot by the time this is called.
+     */
+    void (*freeEffectSlot)(__alDeviceImpl *dev, __alEffectSlotImpl *slot);
+
+    /*
+     * This is called when preparing to process a context and an effect
+     *  slot's state (its effect, or the effect's parameters) has changed
+     *  since the last time the context was processed. This is where you
+     *  should recalculate coefficients, delay line lengths, etc, so that
+     *  rendering never has to.
+     *
+     * Please see comments about multithreading in commitSource(), above.
+     */
+    void (*commitEffectSlot)(__alDeviceImpl *dev, const __alEffectSlot *slot);
+
+    /*
+     * Allocate a submix bus...The AL calls this from the alGenBuses()
+     *  entry point. Buses cost a mix buffer and whatever effects and
+     *  filters they run, so it's fine for this to fail eventually.
+     *
+     * The software mixer gives each bus a mix buffer per quantum. Sources
+     *  routed to a bus mix into it instead of the output, after their own
+     *  gain and filters. Then buses are processed deepest first (see
+     *  __alBusDepth()): the bus's filter and gain are applied to its
+     *  buffer, its sends are fed, and the result is mixed into its parent
+     *  bus, or the output if it has none.
+     *
+     * If you can allocate another bus on the device, return a pointer
+     *  to instance data for this bus. Otherwise, return NULL.
+     */
+    __alBusImpl *(*allocateBus)(__alDeviceImpl *dev, __alContextImpl *ctx);
+
+    /*
+     * Free a previously allocated bus. This is called from alDeleteBuses.
+     *  No sources or buses will route into it by the time this is called.
+     */
+    void (*freeBus)(__alDeviceImpl *dev, __alBusImpl *bus);
+
+    /*
+     * This is called when preparing to process a context and a bus's
+     *  state has changed since the last time the context was processed.
+     *  This is the one call a group-wide change costs, so recalculate the
+     *  bus's filter coefficients here, not while rendering.
+     *
+     * Please see comments about multithreading in commitSource(), above.
+     */
+    void (*commitBus)(__alDeviceImpl *dev, const __alBus *bus);
+
     /*
      * Do rendering, etc. If your implementation is running in parallel, this
      *  might be a no-op. You can use this for general device upkeep, since
@@ -344,6 +806,9 @@ typedef struct S_ALCAPINTERFACE
      *  native conversion and resampling to the requested format, please
      *  do, otherwise, the AL will provide the conversion. On return, set
      *  these arguments to the actual format the implementation will provide.
+     *  The AL converts anything in the four AL formats, at any rate, on its
+     *  way out of pump() (see alConvert.h), so pump() always hands over the
+     *  format you report here, not the one that was asked for.
      *
      * Device interfaces should not be considered singleton in nature; if you
      *  can handle multiple openings of your device (or multiple devices at
@@ -402,8 +867,31 @@ typedef struct S_ALCAPINTERFACE
      *  buffer.
      *
      * Returns the number of bytes retrieved from the capture device.
+     *
+     * If you know when the first frame you're returning was captured, set
+     *  (*timestamp) to that, in nanoseconds on the __alTicksNS() clock
+     *  (alThread.h), translated from the device's own clock if it has one;
+     *  this is what lets applications line capture up with playback. If
+     *  you don't know, leave it alone, and the AL will assume the last
+     *  frame arrived just as pump() returned.
+     *
+     * The AL calls this from its own capture thread while the device is
+     *  started (see alCapture.h), never from two threads at once.
      */
-    ALsizei (*pump)(__alCaptureImpl *dev, ALubyte *buf, ALsizei bufsize);
+    ALsizei (*pump)(__alCaptureImpl *dev, ALubyte *buf, ALsizei bufsize,
+                    unsigned long long *timestamp);
+
+    /*
+     * Block until pump() would return something, or (ms) milliseconds go
+     *  by, whichever is first. If the platform can tell you when data
+     *  arrives (poll() on a file descriptor, an event handle, a callback
+     *  you can signal from), this lets the capture thread sleep until
+     *  then instead of guessing. Returning early is harmless.
+     *
+     * This may be NULL, in which case the capture thread works out how
+     *  often the device delivers and polls pump() at about that rate.
+     */
+    void (*wait)(__alCaptureImpl *dev, ALuint ms);
 } __alCaptureInterface;
 
 
@@ -421,14 +909,202 @@ typedef struct S_ALDEV
     __alContext *contexts;
     ALuint bufferCount;
     __alBuffer *buffers;  /* buffers are shared between ctxs on the device */
+    struct S_ALWORKERPOOL *workers;  /* async uploads; started on demand. */
 } __alDevice;
 
 
+/*
+ * Bytes per sample frame of (fmt), or zero for formats we don't know.
+ *  ADPCM formats are zero here too, since their frames aren't whole
+ *  bytes; they come in blocks, see __alAdpcmBlockAlign().
+ */
+ALsizei __alFormatFrameSize(ALenum fmt);
+
+/*
+ * Set (buf)'s AL_UNPACK_BLOCK_ALIGNMENT_SOFT: sample frames per block
+ *  for ADPCM data uploaded from now on, or zero for the default. Whether
+ *  the format can have blocks that size is checked at upload. Returns
+ *  AL_INVALID_VALUE if (frames) is negative.
+ */
+ALenum __alBufferBlockAlignment(__alBuffer *buf, ALsizei frames);
+
+/*
+ * Set (buf)'s AL_BUFFER_STORAGE_IOAL: AL_NONE or one of the
+ *  AL_STORAGE_*_IOAL values. It applies from the next upload on; what's
+ *  there now stays as it is. Returns AL_INVALID_VALUE for anything else,
+ *  or AL_INVALID_OPERATION while the buffer is uploading.
+ */
+ALenum __alBufferStorage(__alBuffer *buf, ALenum storage);
+
+/*
+ * Route (bus) into (parent), or to the output if (parent) is NULL.
+ *  Returns AL_INVALID_OPERATION if that would make a loop, AL_NO_ERROR
+ *  otherwise.
+ */
+ALenum __alBusSetParent(__alBus *bus, __alBus *parent);
+
+/* How many buses (bus) goes through to reach the output; zero for none. */
+ALsizei __alBusDepth(const __alBus *bus);
+
+/*
+ * The guts of alBufferCallbackSOFT(). Returns AL_INVALID_ENUM for an
+ *  unknown format, AL_INVALID_VALUE for a bad callback or frequency,
+ *  AL_INVALID_OPERATION if the device doesn't do callback buffers, or
+ *  whatever the device reports.
+ */
+ALenum __alBufferCallbackSOFT(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                              ALsizei freq, __alBufferCallback callback,
+                              ALvoid *userptr);
+
+/*
+ * The guts of alBufferStreamIOAL(): make (buf) play (path) as it's read,
+ *  instead of holding samples. The arguments are those of
+ *  __alStreamOpen(), in alStream.h. The buffer owns the stream from then
+ *  on, and closes it when it's given new data. Returns AL_INVALID_ENUM
+ *  for an unknown format, AL_INVALID_VALUE for a bad frequency or if the
+ *  file can't be opened and read as asked, AL_INVALID_OPERATION if the
+ *  device doesn't do stream buffers, the buffer has views or is
+ *  uploading, or whatever the device reports.
+ */
+ALenum __alBufferStream(__alDevice *dev, __alBuffer *buf, const char *path,
+                        ALenum fmt, ALsizei freq,
+                        unsigned long long dataOffset,
+                        unsigned long long dataSize,
+                        ALsizei window, ALsizei chunk, ALboolean loop);
+
+/*
+ * The guts of alBufferDataStatic(). (data) must outlive the buffer's use
+ *  of it; see uploadBufferStatic(). ADPCM data comes in blocks of the
+ *  buffer's AL_UNPACK_BLOCK_ALIGNMENT_SOFT. Returns AL_INVALID_VALUE for
+ *  a bad size, frequency or block alignment, AL_INVALID_ENUM for an
+ *  unknown format, AL_INVALID_OPERATION if the buffer has views or is
+ *  uploading, or whatever the device reports.
+ */
+ALenum __alBufferDataStatic(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                            const ALvoid *data, ALsizei size, ALsizei freq);
+
+struct S_ALFENCE;  /* see alWorker.h */
+
+/*
+ * The guts of alBufferDataAsyncIOAL(): alBufferData(), but the conversion
+ *  happens on one of the device's worker threads and this returns as soon
+ *  as the job is queued. If (owned) is AL_TRUE, the AL takes (data), which
+ *  must have come from malloc(), and frees it when it's done; otherwise it
+ *  copies (data) first, so the application can reuse it right away.
+ *
+ * (fence), if not NULL, is armed here and signaled with the upload's
+ *  result when it finishes; see alWorker.h. Until then the buffer is off
+ *  limits: everything else that would change it or read its samples
+ *  returns AL_INVALID_OPERATION. If a worker can't be started, the upload
+ *  just happens before this returns, and the fence is already signaled.
+ *  A view stays a view of its parent, pinning it, until the upload has
+ *  succeeded; if it fails, the buffer keeps what it had.
+ *
+ * ADPCM data comes in blocks of the buffer's
+ *  AL_UNPACK_BLOCK_ALIGNMENT_SOFT, as it was when this was called.
+ *
+ * Returns AL_INVALID_VALUE for a bad size, frequency or block alignment,
+ *  AL_INVALID_ENUM for an unknown format, AL_INVALID_OPERATION if the
+ *  buffer has views or is already uploading, or AL_OUT_OF_MEMORY. The
+ *  device's own errors arrive through (fence). If this fails and (owned)
+ *  is AL_TRUE, (data) still belongs to the caller.
+ */
+ALenum __alBufferDataAsync(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                           ALvoid *data, ALsizei size, ALsizei freq,
+                           ALboolean owned, struct S_ALFENCE *fence);
+
+/*
+ * Block until (buf) has no async upload in flight. alDeleteBuffers() uses
+ *  this, since a worker may still be writing to the buffer.
+ */
+void __alBufferWaitUpload(__alBuffer *buf);
+
+/*
+ * The device's worker pool, started the first time anyone asks. Returns
+ *  NULL if threads can't be had; everything that takes a pool works
+ *  without one, just on the calling thread.
+ */
+struct S_ALWORKERPOOL *__alDeviceWorkers(__alDevice *dev);
+
+/*
+ * Finish every async upload on (dev) and stop its worker threads, for
+ *  alcCloseDevice(). Call this before freeing the device's buffers.
+ */
+void __alDeviceStopWorkers(__alDevice *dev);
+
+/*
+ * The guts of alBufferSubDataSOFT(). Writes (length) bytes of (data) into
+ *  (buf) starting (offset) bytes in. Returns AL_INVALID_ENUM if (fmt)
+ *  isn't the buffer's format, AL_INVALID_VALUE for a bad or misaligned
+ *  range, AL_INVALID_OPERATION if the buffer doesn't own sample data
+ *  (callback, stream and static buffers), is still uploading, or the
+ *  device can't do it, or whatever the device reports.
+ */
+ALenum __alBufferSubData(__alDevice *dev, __alBuffer *buf, ALenum fmt,
+                         const ALvoid *data, ALsizei offset, ALsizei length);
+
+/*
+ * The guts of alBufferViewIOAL(): make (buf) play (frames) sample frames of
+ *  (parent) from frame (offset), without copying. A view of a view becomes
+ *  a view of the original. Returns AL_INVALID_VALUE for a bad range,
+ *  AL_INVALID_OPERATION if (parent) has no samples to share (callback and
+ *  stream buffers, or itself), if (buf) has views of its own, or if the
+ *  device can't do views, or whatever the device reports.
+ */
+ALenum __alBufferView(__alDevice *dev, __alBuffer *buf, __alBuffer *parent,
+                      ALsizei offset, ALsizei frames);
+
+/*
+ * Pull (bytes) from a callback buffer into (dst), for the mixer. If the
+ *  callback comes up short, the rest is filled with silence in the
+ *  buffer's format (0x80 for 8-bit, which is unsigned, zeros otherwise)
+ *  and AL_FALSE is returned to say the buffer has ended. Returns AL_TRUE
+ *  otherwise.
+ */
+ALboolean __alBufferCallbackPull(const __alBuffer *buf, ALvoid *dst,
+                                 ALsizei bytes);
+
+
+/*
+ * alcCaptureOpenDevice() returns an opaque pointer to an __alCapture. The
+ *  AL core moves data from pump() into a ring, and alcCaptureSamples()
+ *  reads it from there; see alCapture.h.
+ */
 typedef struct S_ALCAP
 {
     __alCaptureInterface *interface;
     __alCaptureImpl *impl;
-    // !!! FIXME: ring buffer, format info, etc go here.
+    ALuint frequency;            /* as the application asked for it. */
+    ALenum format;
+    ALsizei frameSize;
+    struct S_ALRING *ring;       /* pump() -> application; alRing.h */
+    ALubyte *scratch;            /* where pump() goes when the ring's full. */
+
+    /* what open() said pump() really delivers. */
+    ALuint deviceFrequency;
+    ALenum deviceFormat;
+    ALsizei deviceFrameSize;
+    struct S_ALCONVERTER *converter;  /* NULL if it's what was asked for. */
+    ALubyte *converted;          /* converter output that needs a copy. */
+    ALsizei borrowed[__AL_MAX_CAPTURE_READERS];  /* __alCaptureAcquire() */
+    ALuint pumping;              /* atomic; held by whoever's pumping. */
+    struct S_ALCAPTURESTAMP *stamps;  /* when deliveries were captured. */
+    ALuint stampCount;           /* made so far; the producer's. */
+
+    /* the capture thread; see alCapture.h. */
+    struct S_ALTHREAD *thread;   /* NULL when stopped. */
+    struct S_ALSEMAPHORE *wake;
+    ALuint quit;                 /* atomic. */
+    ALboolean capturing;         /* between start() and stop(). */
+    ALuint pollMS;               /* atomic; for __alCaptureGetStats(). */
+    ALuint intervalMS;           /* how often the device delivers. */
+    unsigned long long lastDelivery;  /* __alTicksNS() */
+    ALboolean overrunning;       /* dropping right now. */
+
+    /* atomic; see __alCaptureStats. */
+    ALuint overruns;
+    ALuint dropped;
+    ALuint peakFill;
 } __alCapture;
 
 #endif
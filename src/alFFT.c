@@ -0,0 +1,228 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define __AL_FFT_SSE 1
+#endif
+
+#include "al.h"
+#include "alFFT.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * This is a plain iterative radix-2 decimation-in-time transform. The
+ *  twiddles are stored per stage (the stage with (half) butterflies per
+ *  group uses entries [half-1, 2*half-1)), so the inner loop reads them
+ *  contiguously instead of striding through one big table. That costs us
+ *  nothing in memory (size-1 entries either way) and lets the stages with
+ *  four or more butterflies per group run four at a time.
+ */
+
+int __alFFTInit(__alFFT *fft, ALsizei size)
+{
+    ALsizei bits = 0;
+    ALsizei half;
+    ALsizei i;
+
+    fft->size = 0;
+    fft->bitrev = NULL;
+    fft->twiddleRe = fft->twiddleIm = NULL;
+
+    if ((size < 2) || ((size & (size - 1)) != 0))
+        return 0;
+
+    while ((1 << bits) < size)
+        bits++;
+
+    fft->bitrev = (ALsizei *) malloc(sizeof (ALsizei) * size);
+    fft->twiddleRe = (ALfloat *) malloc(sizeof (ALfloat) * size);
+    fft->twiddleIm = (ALfloat *) malloc(sizeof (ALfloat) * size);
+    if ((!fft->bitrev) || (!fft->twiddleRe) || (!fft->twiddleIm))
+    {
+        __alFFTDeinit(fft);
+        return 0;
+    } /* if */
+
+    for (i = 0; i < size; i++)
+    {
+        ALsizei r = 0;
+        ALsizei b;
+        for (b = 0; b < bits; b++)
+        {
+            if (i & (1 << b))
+                r |= 1 << (bits - 1 - b);
+        } /* for */
+        fft->bitrev[i] = r;
+    } /* for */
+
+    for (half = 1; half < size; half <<= 1)
+    {
+        for (i = 0; i < half; i++)
+        {
+            const double angle = (-M_PI * (double) i) / (double) half;
+            fft->twiddleRe[(half - 1) + i] = (ALfloat) cos(angle);
+            fft->twiddleIm[(half - 1) + i] = (ALfloat) sin(angle);
+        } /* for */
+    } /* for */
+
+    fft->size = size;
+    return 1;
+} /* __alFFTInit */
+
+
+void __alFFTDeinit(__alFFT *fft)
+{
+    free(fft->bitrev);
+    free(fft->twiddleRe);
+    free(fft->twiddleIm);
+    fft->bitrev = NULL;
+    fft->twiddleRe = fft->twiddleIm = NULL;
+    fft->size = 0;
+} /* __alFFTDeinit */
+
+
+static void fftPermute(const __alFFT *fft, ALfloat *re, ALfloat *im)
+{
+    const ALsizei *bitrev = fft->bitrev;
+    const ALsizei size = fft->size;
+    ALsizei i;
+
+    for (i = 0; i < size; i++)
+    {
+        const ALsizei j = bitrev[i];
+        if (i < j)
+        {
+            ALfloat tmp = re[i]; re[i] = re[j]; re[j] = tmp;
+            tmp = im[i]; im[i] = im[j]; im[j] = tmp;
+        } /* if */
+    } /* for */
+} /* fftPermute */
+
+
+static void fftStageScalar(ALfloat *re, ALfloat *im, ALsizei size,
+                           ALsizei half, const ALfloat *wre,
+                           const ALfloat *wim)
+{
+    ALsizei group;
+    ALsizei j;
+
+    for (group = 0; group < size; group += half * 2)
+    {
+        ALfloat *are = re + group;
+        ALfloat *aim = im + group;
+        ALfloat *bre = are + half;
+        ALfloat *bim = aim + half;
+        for (j = 0; j < half; j++)
+        {
+            const ALfloat tre = (bre[j] * wre[j]) - (bim[j] * wim[j]);
+            const ALfloat tim = (bre[j] * wim[j]) + (bim[j] * wre[j]);
+            bre[j] = are[j] - tre;
+            bim[j] = aim[j] - tim;
+            are[j] += tre;
+            aim[j] += tim;
+        } /* for */
+    } /* for */
+} /* fftStageScalar */
+
+
+#if __AL_FFT_SSE
+static void fftStageSSE(ALfloat *re, ALfloat *im, ALsizei size,
+                        ALsizei half, const ALfloat *wre,
+                        const ALfloat *wim)
+{
+    ALsizei group;
+    ALsizei j;
+
+    /* (half) is a multiple of four here. */
+    for (group = 0; group < size; group += half * 2)
+    {
+        ALfloat *are = re + group;
+        ALfloat *aim = im + group;
+        ALfloat *bre = are + half;
+        ALfloat *bim = aim + half;
+        for (j = 0; j < half; j += 4)
+        {
+            const __m128 vwre = _mm_loadu_ps(wre + j);
+            const __m128 vwim = _mm_loadu_ps(wim + j);
+            const __m128 vbre = _mm_loadu_ps(bre + j);
+            const __m128 vbim = _mm_loadu_ps(bim + j);
+            const __m128 vare = _mm_loadu_ps(are + j);
+            const __m128 vaim = _mm_loadu_ps(aim + j);
+            const __m128 tre = _mm_sub_ps(_mm_mul_ps(vbre, vwre),
+                                          _mm_mul_ps(vbim, vwim));
+            const __m128 tim = _mm_add_ps(_mm_mul_ps(vbre, vwim),
+                                          _mm_mul_ps(vbim, vwre));
+            _mm_storeu_ps(bre + j, _mm_sub_ps(vare, tre));
+            _mm_storeu_ps(bim + j, _mm_sub_ps(vaim, tim));
+            _mm_storeu_ps(are + j, _mm_add_ps(vare, tre));
+            _mm_storeu_ps(aim + j, _mm_add_ps(vaim, tim));
+        } /* for */
+    } /* for */
+} /* fftStageSSE */
+#endif
+
+
+void __alFFTForward(const __alFFT *fft, ALfloat *re, ALfloat *im)
+{
+    const ALsizei size = fft->size;
+    ALsizei half;
+
+    fftPermute(fft, re, im);
+
+    for (half = 1; half < size; half <<= 1)
+    {
+        const ALfloat *wre = fft->twiddleRe + (half - 1);
+        const ALfloat *wim = fft->twiddleIm + (half - 1);
+        #if __AL_FFT_SSE
+        if (half >= 4)
+        {
+            fftStageSSE(re, im, size, half, wre, wim);
+            continue;
+        } /* if */
+        #endif
+        fftStageScalar(re, im, size, half, wre, wim);
+    } /* for */
+} /* __alFFTForward */
+
+
+void __alFFTMultiplyAccumulate(ALfloat *accRe, ALfloat *accIm,
+                               const ALfloat *aRe, const ALfloat *aIm,
+                               const ALfloat *bRe, const ALfloat *bIm,
+                               ALsizei count)
+{
+    ALsizei i = 0;
+
+    #if __AL_FFT_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 var = _mm_loadu_ps(aRe + i);
+        const __m128 vai = _mm_loadu_ps(aIm + i);
+        const __m128 vbr = _mm_loadu_ps(bRe + i);
+        const __m128 vbi = _mm_loadu_ps(bIm + i);
+        const __m128 re = _mm_sub_ps(_mm_mul_ps(var, vbr), _mm_mul_ps(vai, vbi));
+        const __m128 im = _mm_add_ps(_mm_mul_ps(var, vbi), _mm_mul_ps(vai, vbr));
+        _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+        _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+    } /* for */
+    #endif
+
+    for (; i < count; i++)
+    {
+        accRe[i] += (aRe[i] * bRe[i]) - (aIm[i] * bIm[i]);
+        accIm[i] += (aRe[i] * bIm[i]) + (aIm[i] * bRe[i]);
+    } /* for */
+} /* __alFFTMultiplyAccumulate */
+
+/* end of alFFT.c ... */
@@ -0,0 +1,64 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALFFT_H_
+#define _INCL_ALFFT_H_
+
+/*
+ * A small complex FFT for the software mixer's convolution stages (HRTF,
+ *  convolution reverb, etc). This is not meant to compete with FFTW; it
+ *  only handles power-of-two sizes, but it's fast enough for the block
+ *  sizes we care about, has no dependencies, and vectorizes well.
+ *
+ * Data is kept "split complex": real and imaginary parts live in separate
+ *  arrays, so the butterflies can operate on four (or more) bins at once
+ *  without any shuffling.
+ *
+ * There is no separate inverse transform routine: an inverse FFT is a
+ *  forward FFT with the real and imaginary arrays swapped, so call
+ *  __alFFTInverse(), which does exactly that. Neither direction scales the
+ *  output; if you need the 1/N factor, fold it into something you were
+ *  going to multiply anyhow (filter spectra are a good place).
+ */
+
+typedef struct S_ALFFT
+{
+    ALsizei size;       /* number of points; always a power of two. */
+    ALsizei *bitrev;    /* (size) entries of bit-reversed indices. */
+    ALfloat *twiddleRe; /* per-stage twiddles, (size - 1) entries total. */
+    ALfloat *twiddleIm;
+} __alFFT;
+
+/*
+ * Prepare an FFT of (size) points. (size) must be a power of two, at
+ *  least 2. Returns non-zero on success, zero on failure (bad size or
+ *  out of memory).
+ */
+int __alFFTInit(__alFFT *fft, ALsizei size);
+
+/* Release anything allocated by __alFFTInit(). Safe to call twice. */
+void __alFFTDeinit(__alFFT *fft);
+
+/* In-place forward transform of (fft->size) split-complex points. */
+void __alFFTForward(const __alFFT *fft, ALfloat *re, ALfloat *im);
+
+/* In-place inverse transform, unscaled. See notes above. */
+#define __alFFTInverse(fft, re, im) __alFFTForward(fft, im, re)
+
+/*
+ * acc += a * b, for (count) split-complex bins. This is the inner loop of
+ *  every partitioned convolution we do, so it gets the SIMD treatment.
+ */
+void __alFFTMultiplyAccumulate(ALfloat *accRe, ALfloat *accIm,
+                               const ALfloat *aRe, const ALfloat *aIm,
+                               const ALfloat *bRe, const ALfloat *bIm,
+                               ALsizei count);
+
+#endif
+
+/* end of alFFT.h ... */
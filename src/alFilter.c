@@ -0,0 +1,328 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define __AL_FILTER_AVX 1
+#endif
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define __AL_FILTER_SSE 1
+#endif
+
+#include "al.h"
+#include "alFilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define LF_REFERENCE 250.0f
+#define HF_REFERENCE 5000.0f
+
+/* coefficient indices. */
+#define B0 0
+#define B1 1
+#define B2 2
+#define A1 3
+#define A2 4
+
+
+static void setIdentity(__alFilterBank *bank, ALsizei section, ALsizei lane,
+                        ALfloat gain)
+{
+    bank->coeff[section][B0][lane] = gain;
+    bank->coeff[section][B1][lane] = 0.0f;
+    bank->coeff[section][B2][lane] = 0.0f;
+    bank->coeff[section][A1][lane] = 0.0f;
+    bank->coeff[section][A2][lane] = 0.0f;
+} /* setIdentity */
+
+
+/*
+ * RBJ cookbook shelf with a slope of 1, reaching (gain) at the extreme,
+ *  normalized so a0 is 1 and scaled by (outgain).
+ */
+static void setShelf(__alFilterBank *bank, ALsizei section, ALsizei lane,
+                     int highShelf, ALfloat gain, ALfloat f0,
+                     ALfloat outgain)
+{
+    const double w0 = (2.0 * M_PI * f0) / ((double) bank->frequency);
+    const double cw = cos(w0);
+    const double alpha = (sin(w0) / 2.0) * sqrt(2.0);
+    double A, sqA, b0, b1, b2, a0, a1, a2;
+
+    if (gain < 0.001f)
+        gain = 0.001f;  /* -60dB; the shelf degenerates at zero. */
+
+    A = sqrt((double) gain);
+    sqA = 2.0 * sqrt(A) * alpha;
+
+    if (highShelf)
+    {
+        b0 = A * ((A + 1.0) + ((A - 1.0) * cw) + sqA);
+        b1 = -2.0 * A * ((A - 1.0) + ((A + 1.0) * cw));
+        b2 = A * ((A + 1.0) + ((A - 1.0) * cw) - sqA);
+        a0 = (A + 1.0) - ((A - 1.0) * cw) + sqA;
+        a1 = 2.0 * ((A - 1.0) - ((A + 1.0) * cw));
+        a2 = (A + 1.0) - ((A - 1.0) * cw) - sqA;
+    } /* if */
+    else
+    {
+        b0 = A * ((A + 1.0) - ((A - 1.0) * cw) + sqA);
+        b1 = 2.0 * A * ((A - 1.0) - ((A + 1.0) * cw));
+        b2 = A * ((A + 1.0) - ((A - 1.0) * cw) - sqA);
+        a0 = (A + 1.0) + ((A - 1.0) * cw) + sqA;
+        a1 = -2.0 * ((A - 1.0) + ((A + 1.0) * cw));
+        a2 = (A + 1.0) + ((A - 1.0) * cw) - sqA;
+    } /* else */
+
+    bank->coeff[section][B0][lane] = (ALfloat) ((b0 / a0) * outgain);
+    bank->coeff[section][B1][lane] = (ALfloat) ((b1 / a0) * outgain);
+    bank->coeff[section][B2][lane] = (ALfloat) ((b2 / a0) * outgain);
+    bank->coeff[section][A1][lane] = (ALfloat) (a1 / a0);
+    bank->coeff[section][A2][lane] = (ALfloat) (a2 / a0);
+} /* setShelf */
+
+
+int __alFilterBankInit(__alFilterBank *bank, ALsizei lanes, ALuint freq)
+{
+    __alFilterState nullFilter;
+    ALsizei i;
+
+    if ((lanes != 4) && (lanes != 8) && (lanes != 16))
+        return 0;
+
+    memset(bank, '\0', sizeof (*bank));
+    bank->lanes = lanes;
+    bank->frequency = freq;
+
+    nullFilter.type = AL_FILTER_NULL;
+    nullFilter.gain = nullFilter.gainHF = nullFilter.gainLF = 1.0f;
+    for (i = 0; i < lanes; i++)
+        __alFilterBankSetLane(bank, i, &nullFilter);
+
+    return 1;
+} /* __alFilterBankInit */
+
+
+void __alFilterBankSetLane(__alFilterBank *bank, ALsizei lane,
+                           const __alFilterState *filter)
+{
+    /* the overall gain rides along in the first section's feedforward. */
+    switch (filter->type)
+    {
+        case AL_FILTER_LOWPASS:
+            setShelf(bank, 0, lane, 1, filter->gainHF, HF_REFERENCE,
+                     filter->gain);
+            setIdentity(bank, 1, lane, 1.0f);
+            break;
+
+        case AL_FILTER_HIGHPASS:
+            setIdentity(bank, 0, lane, filter->gain);
+            setShelf(bank, 1, lane, 0, filter->gainLF, LF_REFERENCE, 1.0f);
+            break;
+
+        case AL_FILTER_BANDPASS:
+            setShelf(bank, 0, lane, 1, filter->gainHF, HF_REFERENCE,
+                     filter->gain);
+            setShelf(bank, 1, lane, 0, filter->gainLF, LF_REFERENCE, 1.0f);
+            break;
+
+        default:  /* AL_FILTER_NULL */
+            setIdentity(bank, 0, lane, 1.0f);
+            setIdentity(bank, 1, lane, 1.0f);
+            break;
+    } /* switch */
+} /* __alFilterBankSetLane */
+
+
+void __alFilterBankResetLane(__alFilterBank *bank, ALsizei lane)
+{
+    ALsizei i;
+    for (i = 0; i < __AL_FILTER_SECTIONS; i++)
+        bank->state[i][0][lane] = bank->state[i][1][lane] = 0.0f;
+} /* __alFilterBankResetLane */
+
+
+void __alFilterBankInterleave(const __alFilterBank *bank, ALsizei lane,
+                              const ALfloat *src, ALfloat *io,
+                              ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    ALsizei i;
+
+    io += lane;
+    for (i = 0; i < frames; i++, io += lanes)
+        *io = src[i];
+} /* __alFilterBankInterleave */
+
+
+void __alFilterBankDeinterleave(const __alFilterBank *bank, ALsizei lane,
+                                const ALfloat *io, ALfloat *dst,
+                                ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    ALsizei i;
+
+    io += lane;
+    for (i = 0; i < frames; i++, io += lanes)
+        dst[i] = *io;
+} /* __alFilterBankDeinterleave */
+
+
+#if __AL_FILTER_AVX
+static void processAVX(__alFilterBank *bank, ALsizei first,
+                       ALfloat *io, ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    __m256 b0[__AL_FILTER_SECTIONS], b1[__AL_FILTER_SECTIONS];
+    __m256 b2[__AL_FILTER_SECTIONS], a1[__AL_FILTER_SECTIONS];
+    __m256 a2[__AL_FILTER_SECTIONS];
+    __m256 z1[__AL_FILTER_SECTIONS], z2[__AL_FILTER_SECTIONS];
+    ALsizei s, t;
+
+    for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+    {
+        b0[s] = _mm256_loadu_ps(&bank->coeff[s][B0][first]);
+        b1[s] = _mm256_loadu_ps(&bank->coeff[s][B1][first]);
+        b2[s] = _mm256_loadu_ps(&bank->coeff[s][B2][first]);
+        a1[s] = _mm256_loadu_ps(&bank->coeff[s][A1][first]);
+        a2[s] = _mm256_loadu_ps(&bank->coeff[s][A2][first]);
+        z1[s] = _mm256_loadu_ps(&bank->state[s][0][first]);
+        z2[s] = _mm256_loadu_ps(&bank->state[s][1][first]);
+    } /* for */
+
+    io += first;
+    for (t = 0; t < frames; t++, io += lanes)
+    {
+        __m256 x = _mm256_loadu_ps(io);
+        for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+        {
+            const __m256 y = _mm256_add_ps(_mm256_mul_ps(b0[s], x), z1[s]);
+            z1[s] = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(b1[s], x),
+                                                _mm256_mul_ps(a1[s], y)),
+                                  z2[s]);
+            z2[s] = _mm256_sub_ps(_mm256_mul_ps(b2[s], x),
+                                  _mm256_mul_ps(a2[s], y));
+            x = y;
+        } /* for */
+        _mm256_storeu_ps(io, x);
+    } /* for */
+
+    for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+    {
+        _mm256_storeu_ps(&bank->state[s][0][first], z1[s]);
+        _mm256_storeu_ps(&bank->state[s][1][first], z2[s]);
+    } /* for */
+} /* processAVX */
+#endif
+
+
+#if __AL_FILTER_SSE
+static void processSSE(__alFilterBank *bank, ALsizei first,
+                       ALfloat *io, ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    __m128 b0[__AL_FILTER_SECTIONS], b1[__AL_FILTER_SECTIONS];
+    __m128 b2[__AL_FILTER_SECTIONS], a1[__AL_FILTER_SECTIONS];
+    __m128 a2[__AL_FILTER_SECTIONS];
+    __m128 z1[__AL_FILTER_SECTIONS], z2[__AL_FILTER_SECTIONS];
+    ALsizei s, t;
+
+    for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+    {
+        b0[s] = _mm_loadu_ps(&bank->coeff[s][B0][first]);
+        b1[s] = _mm_loadu_ps(&bank->coeff[s][B1][first]);
+        b2[s] = _mm_loadu_ps(&bank->coeff[s][B2][first]);
+        a1[s] = _mm_loadu_ps(&bank->coeff[s][A1][first]);
+        a2[s] = _mm_loadu_ps(&bank->coeff[s][A2][first]);
+        z1[s] = _mm_loadu_ps(&bank->state[s][0][first]);
+        z2[s] = _mm_loadu_ps(&bank->state[s][1][first]);
+    } /* for */
+
+    io += first;
+    for (t = 0; t < frames; t++, io += lanes)
+    {
+        __m128 x = _mm_loadu_ps(io);
+        for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+        {
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0[s], x), z1[s]);
+            z1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[s], x),
+                                          _mm_mul_ps(a1[s], y)), z2[s]);
+            z2[s] = _mm_sub_ps(_mm_mul_ps(b2[s], x), _mm_mul_ps(a2[s], y));
+            x = y;
+        } /* for */
+        _mm_storeu_ps(io, x);
+    } /* for */
+
+    for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+    {
+        _mm_storeu_ps(&bank->state[s][0][first], z1[s]);
+        _mm_storeu_ps(&bank->state[s][1][first], z2[s]);
+    } /* for */
+} /* processSSE */
+#endif
+
+
+static void processScalar(__alFilterBank *bank, ALsizei first,
+                          ALfloat *io, ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    ALsizei s, t;
+
+    io += first;
+    for (t = 0; t < frames; t++, io += lanes)
+    {
+        ALfloat x = *io;
+        for (s = 0; s < __AL_FILTER_SECTIONS; s++)
+        {
+            const ALfloat *c = &bank->coeff[s][0][first];
+            ALfloat *z1 = &bank->state[s][0][first];
+            ALfloat *z2 = &bank->state[s][1][first];
+            const ALfloat y = (c[B0 * __AL_FILTER_MAX_LANES] * x) + *z1;
+            *z1 = (c[B1 * __AL_FILTER_MAX_LANES] * x) -
+                  (c[A1 * __AL_FILTER_MAX_LANES] * y) + *z2;
+            *z2 = (c[B2 * __AL_FILTER_MAX_LANES] * x) -
+                  (c[A2 * __AL_FILTER_MAX_LANES] * y);
+            x = y;
+        } /* for */
+        *io = x;
+    } /* for */
+} /* processScalar */
+
+
+void __alFilterBankProcess(__alFilterBank *bank, ALfloat *io,
+                           ALsizei frames)
+{
+    const ALsizei lanes = bank->lanes;
+    ALsizei first = 0;
+
+    /*
+     * Each group of lanes runs over the whole block with its coefficients
+     *  and history in registers, striding over the other groups' samples.
+     */
+    #if __AL_FILTER_AVX
+    for (; first + 8 <= lanes; first += 8)
+        processAVX(bank, first, io, frames);
+    #endif
+
+    #if __AL_FILTER_SSE
+    for (; first + 4 <= lanes; first += 4)
+        processSSE(bank, first, io, frames);
+    #endif
+
+    for (; first < lanes; first++)
+        processScalar(bank, first, io, frames);
+} /* __alFilterBankProcess */
+
+/* end of alFilter.c ... */
@@ -0,0 +1,80 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALFILTER_H_
+#define _INCL_ALFILTER_H_
+
+#include "alCore.h"
+
+/*
+ * The software mixer's EFX-style filters, for source direct paths and
+ *  sends (see __alFilterState in alCore.h).
+ *
+ * A biquad is a serial recursion: every output sample depends on the last
+ *  two, so there's nothing to vectorize within a single voice. But every
+ *  voice runs the exact same topology (a high shelf for gainHF, then a low
+ *  shelf for gainLF), so a filter bank runs 4, 8 or 16 voices side by
+ *  side, one voice per SIMD lane. The samples are voice-interleaved:
+ *  frame (t) of lane (v) lives at io[(t * lanes) + v].
+ *
+ * A lowpass voice has an identity low shelf, and a highpass voice has an
+ *  identity high shelf; running the extra section costs far less than
+ *  splitting voices into different banks by filter type would.
+ *
+ * commitSource() is expected to recalculate a lane's coefficients with
+ *  __alFilterBankSetLane() when the source's filters change; rendering
+ *  never does trig. Lanes without a voice should be set to AL_FILTER_NULL
+ *  (which is also what __alFilterBankInit() does), so they pass silence.
+ */
+
+#define __AL_FILTER_MAX_LANES 16
+#define __AL_FILTER_SECTIONS 2
+
+typedef struct S_ALFILTERBANK
+{
+    ALsizei lanes;   /* 4, 8 or 16. */
+    ALuint frequency;
+
+    /* [section][b0, b1, b2, a1, a2][lane] */
+    ALfloat coeff[__AL_FILTER_SECTIONS][5][__AL_FILTER_MAX_LANES];
+
+    /* [section][z1, z2][lane], transposed direct form II. */
+    ALfloat state[__AL_FILTER_SECTIONS][2][__AL_FILTER_MAX_LANES];
+} __alFilterBank;
+
+/*
+ * Set up a bank of (lanes) voices for a mixer running at (freq). Returns
+ *  non-zero on success, zero if (lanes) isn't 4, 8 or 16.
+ */
+int __alFilterBankInit(__alFilterBank *bank, ALsizei lanes, ALuint freq);
+
+/* Recalculate one lane's coefficients from (filter). Keeps history. */
+void __alFilterBankSetLane(__alFilterBank *bank, ALsizei lane,
+                           const __alFilterState *filter);
+
+/* Clear one lane's history, for when a new voice is assigned to it. */
+void __alFilterBankResetLane(__alFilterBank *bank, ALsizei lane);
+
+/*
+ * Copy (frames) samples of one voice into, or out of, its lane in a
+ *  voice-interleaved block.
+ */
+void __alFilterBankInterleave(const __alFilterBank *bank, ALsizei lane,
+                              const ALfloat *src, ALfloat *io,
+                              ALsizei frames);
+void __alFilterBankDeinterleave(const __alFilterBank *bank, ALsizei lane,
+                                const ALfloat *io, ALfloat *dst,
+                                ALsizei frames);
+
+/* Filter (frames) voice-interleaved sample frames in place. */
+void __alFilterBankProcess(__alFilterBank *bank, ALfloat *io,
+                           ALsizei frames);
+
+#endif
+
+/* end of alFilter.h ... */
@@ -0,0 +1,435 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "al.h"
+#include "alHrtf.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static int readUint32(FILE *io, ALuint *val)
+{
+    ALubyte buf[4];
+    if (fread(buf, sizeof (buf), 1, io) != 1)
+        return 0;
+    *val = ((ALuint) buf[0]) | (((ALuint) buf[1]) << 8) |
+           (((ALuint) buf[2]) << 16) | (((ALuint) buf[3]) << 24);
+    return 1;
+} /* readUint32 */
+
+
+static int readFloat32(FILE *io, ALfloat *val)
+{
+    ALuint bits;
+    if (!readUint32(io, &bits))
+        return 0;
+    memcpy(val, &bits, sizeof (*val));
+    return 1;
+} /* readFloat32 */
+
+
+static void directionToVector(ALfloat azimuth, ALfloat elevation,
+                              ALfloat *vec)
+{
+    /* OpenAL coordinates: +x is right, +y is up, -z is straight ahead. */
+    vec[0] = (ALfloat) (sin(azimuth) * cos(elevation));
+    vec[1] = (ALfloat) sin(elevation);
+    vec[2] = (ALfloat) (-cos(azimuth) * cos(elevation));
+} /* directionToVector */
+
+
+static void freeHrirSet(__alHrirSet *set)
+{
+    if (set != NULL)
+    {
+        __alFFTDeinit(&set->fft);
+        free(set->directions);
+        free(set->spectraRe);
+        free(set->spectraIm);
+        free(set);
+    } /* if */
+} /* freeHrirSet */
+
+
+__alHrirSet *__alHrirSetLoad(const char *path, ALuint freq,
+                             ALsizei partitionSize)
+{
+    const ALsizei fftsize = partitionSize * 2;
+    __alHrirSet *set = NULL;
+    ALfloat *left = NULL;
+    ALfloat *right = NULL;
+    ALuint taps, count;
+    ALfloat scale;
+    char magic[8];
+    FILE *io;
+    ALsizei i, p, t;
+
+    io = fopen(path, "rb");
+    if (io == NULL)
+        return NULL;
+
+    if ( (fread(magic, sizeof (magic), 1, io) != 1) ||
+         (memcmp(magic, "ioALHRIR", sizeof (magic)) != 0) )
+        goto loadFailed;
+
+    set = (__alHrirSet *) calloc(1, sizeof (__alHrirSet));
+    if (set == NULL)
+        goto loadFailed;
+
+    if ( (!readUint32(io, &set->frequency)) || (!readUint32(io, &taps)) ||
+         (!readUint32(io, &count)) || (taps == 0) || (count == 0) )
+        goto loadFailed;
+
+    /* !!! FIXME: resample the impulse responses instead of failing here. */
+    if (set->frequency != freq)
+        goto loadFailed;
+
+    if (!__alFFTInit(&set->fft, fftsize))
+        goto loadFailed;
+
+    set->partitionSize = partitionSize;
+    set->partitions = (ALsizei) ((taps + partitionSize - 1) / partitionSize);
+    set->count = (ALsizei) count;
+    set->directions = (ALfloat *) malloc(sizeof (ALfloat) * 3 * count);
+    set->spectraRe = (ALfloat *) malloc(sizeof (ALfloat) * count *
+                                        set->partitions * fftsize);
+    set->spectraIm = (ALfloat *) malloc(sizeof (ALfloat) * count *
+                                        set->partitions * fftsize);
+    left = (ALfloat *) calloc(set->partitions * partitionSize, sizeof (ALfloat));
+    right = (ALfloat *) calloc(set->partitions * partitionSize, sizeof (ALfloat));
+    if ((!set->directions) || (!set->spectraRe) || (!set->spectraIm) ||
+        (!left) || (!right))
+        goto loadFailed;
+
+    /* Fold the inverse FFT's 1/N into the filters, so mixing never has to. */
+    scale = 1.0f / ((ALfloat) fftsize);
+
+    for (i = 0; i < set->count; i++)
+    {
+        ALfloat azimuth, elevation;
+
+        if ((!readFloat32(io, &azimuth)) || (!readFloat32(io, &elevation)))
+            goto loadFailed;
+
+        directionToVector((ALfloat) (azimuth * (M_PI / 180.0)),
+                          (ALfloat) (elevation * (M_PI / 180.0)),
+                          set->directions + (i * 3));
+
+        for (t = 0; t < (ALsizei) taps; t++)
+        {
+            if (!readFloat32(io, &left[t]))
+                goto loadFailed;
+        } /* for */
+
+        for (t = 0; t < (ALsizei) taps; t++)
+        {
+            if (!readFloat32(io, &right[t]))
+                goto loadFailed;
+        } /* for */
+
+        for (p = 0; p < set->partitions; p++)
+        {
+            const ALsizei offset = ((i * set->partitions) + p) * fftsize;
+            ALfloat *re = set->spectraRe + offset;
+            ALfloat *im = set->spectraIm + offset;
+
+            /*
+             * Overlap-save wants each partition in the first half of the
+             *  FFT frame, zero-padded. Packing left into the real part and
+             *  right into the imaginary part gets us HL + i*HR in one go.
+             */
+            for (t = 0; t < partitionSize; t++)
+            {
+                re[t] = left[(p * partitionSize) + t] * scale;
+                im[t] = right[(p * partitionSize) + t] * scale;
+            } /* for */
+            memset(re + partitionSize, '\0', sizeof (ALfloat) * partitionSize);
+            memset(im + partitionSize, '\0', sizeof (ALfloat) * partitionSize);
+            __alFFTForward(&set->fft, re, im);
+        } /* for */
+    } /* for */
+
+    free(left);
+    free(right);
+    fclose(io);
+    return set;
+
+loadFailed:
+    free(left);
+    free(right);
+    freeHrirSet(set);
+    fclose(io);
+    return NULL;
+} /* __alHrirSetLoad */
+
+
+void __alHrirSetFree(__alHrirSet *set)
+{
+    freeHrirSet(set);
+} /* __alHrirSetFree */
+
+
+ALsizei __alHrirSetNearest(const __alHrirSet *set, ALfloat azimuth,
+                           ALfloat elevation)
+{
+    const ALfloat *dir = set->directions;
+    ALfloat best = -2.0f;
+    ALsizei retval = 0;
+    ALfloat vec[3];
+    ALsizei i;
+
+    directionToVector(azimuth, elevation, vec);
+    for (i = 0; i < set->count; i++, dir += 3)
+    {
+        const ALfloat dot = (dir[0]*vec[0]) + (dir[1]*vec[1]) + (dir[2]*vec[2]);
+        if (dot > best)
+        {
+            best = dot;
+            retval = i;
+        } /* if */
+    } /* for */
+
+    return retval;
+} /* __alHrirSetNearest */
+
+
+int __alHrtfVoiceInit(__alHrtfVoice *voice, const __alHrirSet *set)
+{
+    const ALsizei bins = set->partitions * set->fft.size;
+
+    voice->set = set;
+    voice->filter = 0;
+    voice->pendingFilter = -1;
+    voice->fdlPos = 0;
+    voice->history = (ALfloat *) malloc(sizeof (ALfloat) * set->partitionSize);
+    voice->fdlRe = (ALfloat *) malloc(sizeof (ALfloat) * bins);
+    voice->fdlIm = (ALfloat *) malloc(sizeof (ALfloat) * bins);
+    if ((!voice->history) || (!voice->fdlRe) || (!voice->fdlIm))
+    {
+        __alHrtfVoiceDeinit(voice);
+        return 0;
+    } /* if */
+
+    __alHrtfVoiceReset(voice);
+    return 1;
+} /* __alHrtfVoiceInit */
+
+
+void __alHrtfVoiceDeinit(__alHrtfVoice *voice)
+{
+    free(voice->history);
+    free(voice->fdlRe);
+    free(voice->fdlIm);
+    voice->history = voice->fdlRe = voice->fdlIm = NULL;
+} /* __alHrtfVoiceDeinit */
+
+
+void __alHrtfVoiceReset(__alHrtfVoice *voice)
+{
+    const __alHrirSet *set = voice->set;
+    const ALsizei bins = set->partitions * set->fft.size;
+
+    memset(voice->history, '\0', sizeof (ALfloat) * set->partitionSize);
+    memset(voice->fdlRe, '\0', sizeof (ALfloat) * bins);
+    memset(voice->fdlIm, '\0', sizeof (ALfloat) * bins);
+    voice->fdlPos = 0;
+
+    /* nothing to crossfade from, so jump straight to the new filter. */
+    if (voice->pendingFilter >= 0)
+    {
+        voice->filter = voice->pendingFilter;
+        voice->pendingFilter = -1;
+    } /* if */
+} /* __alHrtfVoiceReset */
+
+
+void __alHrtfVoiceSetDirection(__alHrtfVoice *voice, ALfloat azimuth,
+                               ALfloat elevation)
+{
+    const ALsizei nearest = __alHrirSetNearest(voice->set, azimuth, elevation);
+    if (nearest == voice->filter)
+        voice->pendingFilter = -1;
+    else
+        voice->pendingFilter = nearest;
+} /* __alHrtfVoiceSetDirection */
+
+
+int __alHrtfRendererInit(__alHrtfRenderer *r, const __alHrirSet *set)
+{
+    const ALsizei fftsize = set->fft.size;
+
+    memset(r, '\0', sizeof (*r));
+    r->set = set;
+    r->accumRe = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->accumIm = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->scratchRe = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->scratchIm = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->fadeRe = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->fadeIm = (ALfloat *) malloc(sizeof (ALfloat) * fftsize);
+    r->direct = (ALfloat *) malloc(sizeof (ALfloat) * 2 * set->partitionSize);
+    if ((!r->accumRe) || (!r->accumIm) || (!r->scratchRe) ||
+        (!r->scratchIm) || (!r->fadeRe) || (!r->fadeIm) || (!r->direct))
+    {
+        __alHrtfRendererDeinit(r);
+        return 0;
+    } /* if */
+
+    return 1;
+} /* __alHrtfRendererInit */
+
+
+void __alHrtfRendererDeinit(__alHrtfRenderer *r)
+{
+    free(r->accumRe);
+    free(r->accumIm);
+    free(r->scratchRe);
+    free(r->scratchIm);
+    free(r->fadeRe);
+    free(r->fadeIm);
+    free(r->direct);
+    memset(r, '\0', sizeof (*r));
+} /* __alHrtfRendererDeinit */
+
+
+void __alHrtfRendererBegin(__alHrtfRenderer *r)
+{
+    const ALsizei fftsize = r->set->fft.size;
+    memset(r->accumRe, '\0', sizeof (ALfloat) * fftsize);
+    memset(r->accumIm, '\0', sizeof (ALfloat) * fftsize);
+    r->haveDirect = AL_FALSE;
+} /* __alHrtfRendererBegin */
+
+
+/* Run the voice's delay line through one filter, adding into acc. */
+static void convolveVoice(const __alHrtfVoice *voice, ALsizei filter,
+                          ALfloat *accRe, ALfloat *accIm)
+{
+    const __alHrirSet *set = voice->set;
+    const ALsizei fftsize = set->fft.size;
+    const ALsizei partitions = set->partitions;
+    const ALsizei base = filter * partitions * fftsize;
+    ALsizei slot = voice->fdlPos;
+    ALsizei p;
+
+    for (p = 0; p < partitions; p++)
+    {
+        const ALsizei fdloffset = slot * fftsize;
+        const ALsizei hoffset = base + (p * fftsize);
+        __alFFTMultiplyAccumulate(accRe, accIm,
+                                  voice->fdlRe + fdloffset,
+                                  voice->fdlIm + fdloffset,
+                                  set->spectraRe + hoffset,
+                                  set->spectraIm + hoffset, fftsize);
+        slot = (slot == 0) ? (partitions - 1) : (slot - 1);
+    } /* for */
+} /* convolveVoice */
+
+
+void __alHrtfRendererAddVoice(__alHrtfRenderer *r, __alHrtfVoice *voice,
+                              const ALfloat *input)
+{
+    const __alHrirSet *set = voice->set;
+    const ALsizei block = set->partitionSize;
+    const ALsizei fftsize = set->fft.size;
+    ALfloat *re;
+    ALfloat *im;
+
+    /* push this block's spectrum into the frequency-domain delay line. */
+    voice->fdlPos++;
+    if (voice->fdlPos >= set->partitions)
+        voice->fdlPos = 0;
+
+    re = voice->fdlRe + (voice->fdlPos * fftsize);
+    im = voice->fdlIm + (voice->fdlPos * fftsize);
+    memcpy(re, voice->history, sizeof (ALfloat) * block);
+    memcpy(re + block, input, sizeof (ALfloat) * block);
+    memset(im, '\0', sizeof (ALfloat) * fftsize);
+    __alFFTForward(&set->fft, re, im);
+    memcpy(voice->history, input, sizeof (ALfloat) * block);
+
+    if (voice->pendingFilter < 0)
+    {
+        /* steady state: share the inverse FFT with everyone else. */
+        convolveVoice(voice, voice->filter, r->accumRe, r->accumIm);
+    } /* if */
+
+    else
+    {
+        /*
+         * Changing filters; run both and crossfade in the time domain.
+         *  This costs two private inverse FFTs, but only for the quantum
+         *  where the direction actually crossed to another measurement.
+         */
+        const ALfloat step = 1.0f / ((ALfloat) block);
+        ALfloat *out = r->direct;
+        ALsizei i;
+
+        memset(r->scratchRe, '\0', sizeof (ALfloat) * fftsize);
+        memset(r->scratchIm, '\0', sizeof (ALfloat) * fftsize);
+        memset(r->fadeRe, '\0', sizeof (ALfloat) * fftsize);
+        memset(r->fadeIm, '\0', sizeof (ALfloat) * fftsize);
+        convolveVoice(voice, voice->filter, r->scratchRe, r->scratchIm);
+        convolveVoice(voice, voice->pendingFilter, r->fadeRe, r->fadeIm);
+        __alFFTInverse(&set->fft, r->scratchRe, r->scratchIm);
+        __alFFTInverse(&set->fft, r->fadeRe, r->fadeIm);
+
+        if (!r->haveDirect)
+        {
+            memset(out, '\0', sizeof (ALfloat) * 2 * block);
+            r->haveDirect = AL_TRUE;
+        } /* if */
+
+        for (i = 0; i < block; i++)
+        {
+            const ALfloat newgain = step * (ALfloat) i;
+            const ALfloat oldgain = 1.0f - newgain;
+            *(out++) += (r->scratchRe[block + i] * oldgain) +
+                        (r->fadeRe[block + i] * newgain);
+            *(out++) += (r->scratchIm[block + i] * oldgain) +
+                        (r->fadeIm[block + i] * newgain);
+        } /* for */
+
+        voice->filter = voice->pendingFilter;
+        voice->pendingFilter = -1;
+    } /* else */
+} /* __alHrtfRendererAddVoice */
+
+
+void __alHrtfRendererEnd(__alHrtfRenderer *r, ALfloat *output)
+{
+    const __alHrirSet *set = r->set;
+    const ALsizei block = set->partitionSize;
+    const ALfloat *re = r->accumRe + block;
+    const ALfloat *im = r->accumIm + block;
+    ALsizei i;
+
+    /* Left ear comes back in the real part, right ear in the imaginary. */
+    __alFFTInverse(&set->fft, r->accumRe, r->accumIm);
+
+    for (i = 0; i < block; i++)
+    {
+        *(output++) += re[i];
+        *(output++) += im[i];
+    } /* for */
+
+    if (r->haveDirect)
+    {
+        const ALfloat *direct = r->direct;
+        output -= block * 2;
+        for (i = 0; i < block * 2; i++)
+            output[i] += direct[i];
+    } /* if */
+} /* __alHrtfRendererEnd */
+
+/* end of alHrtf.c ... */
@@ -0,0 +1,146 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALHRTF_H_
+#define _INCL_ALHRTF_H_
+
+#include "alFFT.h"
+
+/*
+ * Binaural (HRTF) rendering for headphone output.
+ *
+ * This lives in the software mixer's post-spatialization stage: by the time
+ *  a voice gets here, the mixer has already resampled it, applied distance
+ *  attenuation, cones, gain and filters, and worked out the direction of
+ *  the source relative to the listener. What's left is a mono block per
+ *  voice and an azimuth/elevation, which we turn into a stereo pair by
+ *  convolving with a measured head-related impulse response (HRIR).
+ *
+ * Time domain convolution with a few hundred taps per ear per voice is way
+ *  too expensive, so this uses uniformly partitioned overlap-save
+ *  convolution: the HRIRs are chopped into partitions the size of a mixer
+ *  quantum (B samples), and each partition is pretransformed with a 2B
+ *  point FFT when the set is loaded. Some tricks keep per-voice cost down:
+ *
+ *  - Both ears are packed into one complex spectrum (left + i*right). Both
+ *    impulse responses are real, so the inverse FFT hands them back to us
+ *    in the real and imaginary parts, respectively. That's one complex
+ *    multiply-accumulate per bin per partition for both ears.
+ *  - Convolution is linear, so voices that aren't changing direction
+ *    accumulate their output spectra into one shared buffer and the
+ *    renderer does a single inverse FFT per quantum for all of them.
+ *  - The input spectra of the last P blocks are kept in a frequency-domain
+ *    delay line, so each voice does exactly one forward FFT per quantum,
+ *    no matter how long the HRIR is.
+ *
+ * So a steady voice costs one 2B point FFT plus P spectrum
+ *  multiply-accumulates per quantum. A voice that moves to a different
+ *  measurement gets rendered with both the old and new filters for one
+ *  quantum and crossfaded in the time domain, so we don't click.
+ *
+ * The mixer's quantum must equal the partition size the set was loaded
+ *  with. The mixer is expected to call, once per quantum:
+ *
+ *    __alHrtfRendererBegin(renderer);
+ *    for each playing voice:
+ *        __alHrtfVoiceSetDirection(voice, azimuth, elevation);
+ *        __alHrtfRendererAddVoice(renderer, voice, monoBlock);
+ *    __alHrtfRendererEnd(renderer, stereoOutput);
+ *
+ * The HRIR file format is our own, since there's no good standard one that
+ *  doesn't drag a dependency in. All values are little endian:
+ *
+ *    8 bytes:        "ioALHRIR"
+ *    uint32:         sample rate
+ *    uint32:         impulse response length, in samples
+ *    uint32:         number of measurements
+ *    per measurement:
+ *      float32:      azimuth, in degrees (0 is straight ahead, 90 is right)
+ *      float32:      elevation, in degrees (0 is level, 90 is straight up)
+ *      float32[len]: left ear impulse response
+ *      float32[len]: right ear impulse response
+ */
+
+typedef struct S_ALHRIRSET
+{
+    ALuint frequency;
+    ALsizei partitionSize;   /* B: samples per partition (mixer quantum). */
+    ALsizei partitions;      /* P: partitions per impulse response. */
+    ALsizei count;           /* number of measurements. */
+    ALfloat *directions;     /* (count * 3) unit vectors, x/y/z. */
+    ALfloat *spectraRe;      /* (count * P * 2B) packed left+i*right bins. */
+    ALfloat *spectraIm;
+    __alFFT fft;             /* 2B points. */
+} __alHrirSet;
+
+typedef struct S_ALHRTFVOICE
+{
+    const __alHrirSet *set;
+    ALsizei filter;          /* measurement we're rendering with. */
+    ALsizei pendingFilter;   /* crossfade to this next quantum, or -1. */
+    ALsizei fdlPos;          /* newest slot in the delay line. */
+    ALfloat *history;        /* previous input block (B samples). */
+    ALfloat *fdlRe;          /* (P * 2B) input spectra. */
+    ALfloat *fdlIm;
+} __alHrtfVoice;
+
+typedef struct S_ALHRTFRENDERER
+{
+    const __alHrirSet *set;
+    ALfloat *accumRe;        /* shared output spectrum (2B bins). */
+    ALfloat *accumIm;
+    ALfloat *scratchRe;      /* per-voice work space (2B bins). */
+    ALfloat *scratchIm;
+    ALfloat *fadeRe;         /* second filter during crossfades (2B bins). */
+    ALfloat *fadeIm;
+    ALfloat *direct;         /* crossfaded voices, (B) stereo frames. */
+    ALboolean haveDirect;
+} __alHrtfRenderer;
+
+/*
+ * Load an HRIR set from (path), partitioned for a mixer running at (freq)
+ *  with a quantum of (partitionSize) sample frames, which must be a power
+ *  of two. Returns NULL on failure (missing or malformed file, sample rate
+ *  mismatch, out of memory).
+ */
+__alHrirSet *__alHrirSetLoad(const char *path, ALuint freq,
+                             ALsizei partitionSize);
+void __alHrirSetFree(__alHrirSet *set);
+
+/*
+ * Find the measurement closest to the given direction, in radians, using
+ *  the same conventions as the file format.
+ */
+ALsizei __alHrirSetNearest(const __alHrirSet *set, ALfloat azimuth,
+                           ALfloat elevation);
+
+/* Returns non-zero on success, zero if out of memory. */
+int __alHrtfVoiceInit(__alHrtfVoice *voice, const __alHrirSet *set);
+void __alHrtfVoiceDeinit(__alHrtfVoice *voice);
+
+/* Clear history, for when a source is (re)started. */
+void __alHrtfVoiceReset(__alHrtfVoice *voice);
+
+/* Direction, in radians, relative to the listener. Cheap if unchanged. */
+void __alHrtfVoiceSetDirection(__alHrtfVoice *voice, ALfloat azimuth,
+                               ALfloat elevation);
+
+int __alHrtfRendererInit(__alHrtfRenderer *r, const __alHrirSet *set);
+void __alHrtfRendererDeinit(__alHrtfRenderer *r);
+void __alHrtfRendererBegin(__alHrtfRenderer *r);
+
+/* (input) is one quantum (B samples) of mono audio. */
+void __alHrtfRendererAddVoice(__alHrtfRenderer *r, __alHrtfVoice *voice,
+                              const ALfloat *input);
+
+/* Mixes (adds) B interleaved stereo frames into (output). */
+void __alHrtfRendererEnd(__alHrtfRenderer *r, ALfloat *output);
+
+#endif
+
+/* end of alHrtf.h ... */
@@ -0,0 +1,314 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alPool.h"
+
+#define PRIME1 11400714785074694791ULL
+#define PRIME2 14029467366897019727ULL
+#define PRIME3 1609587929392839161ULL
+#define PRIME4 9650029242287828579ULL
+#define PRIME5 2870177450012600261ULL
+
+static unsigned long long rotl64(unsigned long long x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+} /* rotl64 */
+
+
+static unsigned long long read64(const ALubyte *ptr)
+{
+    unsigned long long retval;
+    memcpy(&retval, ptr, sizeof (retval));  /* may be unaligned. */
+    return retval;
+} /* read64 */
+
+
+static unsigned long long hashRound(unsigned long long acc,
+                                    unsigned long long input)
+{
+    acc += input * PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME1;
+} /* hashRound */
+
+
+unsigned long long __alHash64(const ALvoid *data, size_t len,
+                              unsigned long long seed)
+{
+    const ALubyte *ptr = (const ALubyte *) data;
+    const ALubyte *end = ptr + len;
+    unsigned long long h;
+
+    /*
+     * Host byte order, since these hashes never leave the process. The
+     *  four lanes don't depend on each other, so they pipeline.
+     */
+    if (len >= 32)
+    {
+        unsigned long long v1 = seed + PRIME1 + PRIME2;
+        unsigned long long v2 = seed + PRIME2;
+        unsigned long long v3 = seed;
+        unsigned long long v4 = seed - PRIME1;
+
+        do
+        {
+            v1 = hashRound(v1, read64(ptr));
+            v2 = hashRound(v2, read64(ptr + 8));
+            v3 = hashRound(v3, read64(ptr + 16));
+            v4 = hashRound(v4, read64(ptr + 24));
+            ptr += 32;
+        } while ((end - ptr) >= 32);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = ((h ^ hashRound(0, v1)) * PRIME1) + PRIME4;
+        h = ((h ^ hashRound(0, v2)) * PRIME1) + PRIME4;
+        h = ((h ^ hashRound(0, v3)) * PRIME1) + PRIME4;
+        h = ((h ^ hashRound(0, v4)) * PRIME1) + PRIME4;
+    } /* if */
+    else
+    {
+        h = seed + PRIME5;
+    } /* else */
+
+    h += (unsigned long long) len;
+
+    while ((end - ptr) >= 8)
+    {
+        h ^= hashRound(0, read64(ptr));
+        h = (rotl64(h, 27) * PRIME1) + PRIME4;
+        ptr += 8;
+    } /* while */
+
+    while (ptr < end)
+    {
+        h ^= ((unsigned long long) *(ptr++)) * PRIME5;
+        h = rotl64(h, 11) * PRIME1;
+    } /* while */
+
+    /* final avalanche. */
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+} /* __alHash64 */
+
+
+int __alSamplePoolInit(__alSamplePool *pool, ALuint buckets)
+{
+    ALuint size = 16;
+
+    while (size < buckets)
+        size <<= 1;
+
+    memset(pool, '\0', sizeof (__alSamplePool));
+    pool->buckets = (__alSharedSamples **) calloc(size,
+                                                  sizeof (__alSharedSamples *));
+    if (pool->buckets == NULL)
+        return 0;
+
+    pool->lock = __alMutexCreate();
+    if (pool->lock == NULL)
+    {
+        free(pool->buckets);
+        pool->buckets = NULL;
+        return 0;
+    } /* if */
+
+    pool->bucketCount = size;
+    return 1;
+} /* __alSamplePoolInit */
+
+
+void __alSamplePoolDeinit(__alSamplePool *pool)
+{
+    ALuint i;
+
+    for (i = 0; i < pool->bucketCount; i++)
+    {
+        __alSharedSamples *item = pool->buckets[i];
+        while (item != NULL)
+        {
+            __alSharedSamples *next = item->next;
+            free(item->data);
+            free(item);
+            item = next;
+        } /* while */
+    } /* for */
+
+    if (pool->lock != NULL)
+        __alMutexDestroy(pool->lock);
+    free(pool->buckets);
+    memset(pool, '\0', sizeof (__alSamplePool));
+} /* __alSamplePoolDeinit */
+
+
+/* double the table when chains get long. Failing to grow is harmless. */
+static void growPool(__alSamplePool *pool)
+{
+    const ALuint size = pool->bucketCount * 2;
+    __alSharedSamples **buckets;
+    ALuint i;
+
+    buckets = (__alSharedSamples **) calloc(size, sizeof (__alSharedSamples *));
+    if (buckets == NULL)
+        return;
+
+    for (i = 0; i < pool->bucketCount; i++)
+    {
+        __alSharedSamples *item = pool->buckets[i];
+        while (item != NULL)
+        {
+            __alSharedSamples *next = item->next;
+            const ALuint bucket = (ALuint) (item->hash & (size - 1));
+            item->next = buckets[bucket];
+            buckets[bucket] = item;
+            item = next;
+        } /* while */
+    } /* for */
+
+    free(pool->buckets);
+    pool->buckets = buckets;
+    pool->bucketCount = size;
+} /* growPool */
+
+
+__alSharedSamples *__alSamplePoolInsert(__alSamplePool *pool, ALenum fmt,
+                                        ALsizei freq, const ALvoid *raw,
+                                        ALsizei rawBytes, ALenum storage,
+                                        ALvoid *data, ALsizei bytes)
+{
+    /* hash outside the lock; it's the expensive part. */
+    const unsigned long long hash = __alHash64(raw, (size_t) rawBytes,
+                                               (unsigned long long) fmt);
+    __alSharedSamples *item;
+    ALuint bucket;
+
+    __alMutexLock(pool->lock);
+
+    bucket = (ALuint) (hash & (pool->bucketCount - 1));
+    for (item = pool->buckets[bucket]; item != NULL; item = item->next)
+    {
+        if ( (item->hash == hash) && (item->fmt == fmt) &&
+             (item->freq == freq) && (item->storage == storage) &&
+             (item->bytes == bytes) &&
+             (memcmp(item->data, data, bytes) == 0) )
+        {
+            item->refcount++;
+            pool->bytesSaved += (unsigned long long) bytes;
+            __alMutexUnlock(pool->lock);
+            free(data);  /* we'll use the one we've got. */
+            return item;
+        } /* if */
+    } /* for */
+
+    item = (__alSharedSamples *) malloc(sizeof (__alSharedSamples));
+    if (item == NULL)
+    {
+        __alMutexUnlock(pool->lock);
+        return NULL;
+    } /* if */
+
+    item->hash = hash;
+    item->fmt = fmt;
+    item->freq = freq;
+    item->storage = storage;
+    item->data = data;
+    item->bytes = bytes;
+    item->refcount = 1;
+    item->next = pool->buckets[bucket];
+    pool->buckets[bucket] = item;
+    pool->count++;
+    pool->bytesStored += (unsigned long long) bytes;
+
+    if (pool->count > (pool->bucketCount * 2))
+        growPool(pool);
+
+    __alMutexUnlock(pool->lock);
+    return item;
+} /* __alSamplePoolInsert */
+
+
+static void unlinkSamples(__alSamplePool *pool, __alSharedSamples *samples)
+{
+    __alSharedSamples **ptr;
+
+    ptr = &pool->buckets[samples->hash & (pool->bucketCount - 1)];
+    while (*ptr != samples)
+        ptr = &(*ptr)->next;
+    *ptr = samples->next;
+
+    pool->count--;
+    pool->bytesStored -= (unsigned long long) samples->bytes;
+} /* unlinkSamples */
+
+
+void __alSamplePoolRelease(__alSamplePool *pool, __alSharedSamples *samples)
+{
+    __alMutexLock(pool->lock);
+
+    if (--samples->refcount > 0)
+    {
+        pool->bytesSaved -= (unsigned long long) samples->bytes;
+        __alMutexUnlock(pool->lock);
+        return;
+    } /* if */
+
+    unlinkSamples(pool, samples);
+    __alMutexUnlock(pool->lock);
+
+    free(samples->data);
+    free(samples);
+} /* __alSamplePoolRelease */
+
+
+ALvoid *__alSamplePoolUnshare(__alSamplePool *pool,
+                              __alSharedSamples *samples)
+{
+    ALvoid *retval;
+
+    __alMutexLock(pool->lock);
+
+    if (samples->refcount == 1)  /* all ours; take it out of the pool. */
+    {
+        unlinkSamples(pool, samples);
+        __alMutexUnlock(pool->lock);
+        retval = samples->data;
+        free(samples);
+        return retval;
+    } /* if */
+
+    /* still locked, so nobody can release it out from under the copy. */
+    retval = malloc(samples->bytes);
+    if (retval != NULL)
+    {
+        memcpy(retval, samples->data, samples->bytes);
+        samples->refcount--;
+        pool->bytesSaved -= (unsigned long long) samples->bytes;
+    } /* if */
+
+    __alMutexUnlock(pool->lock);
+    return retval;
+} /* __alSamplePoolUnshare */
+
+
+void __alSamplePoolStats(__alSamplePool *pool, unsigned long long *stored,
+                         unsigned long long *saved)
+{
+    __alMutexLock(pool->lock);
+    *stored = pool->bytesStored;
+    *saved = pool->bytesSaved;
+    __alMutexUnlock(pool->lock);
+} /* __alSamplePoolStats */
+
+/* end of alPool.c ... */
@@ -0,0 +1,113 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALPOOL_H_
+#define _INCL_ALPOOL_H_
+
+#include <stddef.h>
+
+#include "alCore.h"
+#include "alThread.h"
+
+/*
+ * Shared sample storage.
+ *
+ * Games with lots of mods tend to upload the same sound under a dozen
+ *  buffer names. The sample pool makes those buffers share one copy of
+ *  the converted samples: uploadBuffer() hashes the incoming data, and
+ *  if the pool already has storage from identical input (same bytes,
+ *  format, frequency and storage format), the buffer takes a reference
+ *  to that instead of keeping its own.
+ *
+ * A matching hash is only a hint. The candidate is checked with memcmp()
+ *  against the new upload's converted samples before anything is shared,
+ *  so a collision costs a comparison, never wrong audio. Conversion is
+ *  deterministic, so equal input always gives equal storage.
+ *
+ * Shared storage is read-only; a buffer that's given new data (or
+ *  deleted) drops its reference, and the storage goes away with the last
+ *  one. The pool keeps count of how many bytes it saved, for the curious.
+ *
+ * The pool has its own lock, taken only while uploading or releasing, so
+ *  it never gets in the mixer's way.
+ */
+
+typedef struct S_ALSHAREDSAMPLES
+{
+    struct S_ALSHAREDSAMPLES *next;  /* hash chain. */
+    unsigned long long hash;         /* of the raw upload. */
+    ALenum fmt;
+    ALsizei freq;
+    ALenum storage;
+    ALvoid *data;                    /* converted samples; read-only. */
+    ALsizei bytes;
+    ALuint refcount;
+} __alSharedSamples;
+
+typedef struct S_ALSAMPLEPOOL
+{
+    __alMutex *lock;
+    ALuint bucketCount;              /* a power of two. */
+    __alSharedSamples **buckets;
+    ALuint count;                    /* distinct entries. */
+    unsigned long long bytesStored;  /* what we actually hold. */
+    unsigned long long bytesSaved;   /* what duplicates would have held. */
+} __alSamplePool;
+
+/* Returns zero on failure. (buckets) is rounded up to a power of two. */
+int __alSamplePoolInit(__alSamplePool *pool, ALuint buckets);
+
+/* Every entry should have been released by now; any left are freed. */
+void __alSamplePoolDeinit(__alSamplePool *pool);
+
+/*
+ * A fast, non-cryptographic 64-bit hash of (len) bytes at (data). It's
+ *  xxHash64-like: four independent multiply-rotate lanes, eight bytes at
+ *  a time, so it runs at memory speed.
+ */
+unsigned long long __alHash64(const ALvoid *data, size_t len,
+                              unsigned long long seed);
+
+/*
+ * Add storage to the pool. (raw) and (rawBytes) are the upload as the
+ *  application handed it over, in (fmt) at (freq): uploadBuffer()'s
+ *  (data) and (size). (data) is that upload converted to (storage),
+ *  (bytes) long, allocated with malloc(); for ADPCM kept as it is, that's
+ *  just a copy of (raw), and buffers may share it whatever their block
+ *  alignment, since each keeps its own.
+ *
+ * If the pool already holds the same thing, (data) is freed and the
+ *  existing entry is returned with another reference. Otherwise the pool
+ *  takes ownership of (data) in a new entry. Returns NULL, without
+ *  freeing (data), if out of memory.
+ */
+__alSharedSamples *__alSamplePoolInsert(__alSamplePool *pool, ALenum fmt,
+                                        ALsizei freq, const ALvoid *raw,
+                                        ALsizei rawBytes, ALenum storage,
+                                        ALvoid *data, ALsizei bytes);
+
+/* Drop a reference; the storage is freed with the last one. */
+void __alSamplePoolRelease(__alSamplePool *pool, __alSharedSamples *samples);
+
+/*
+ * Trade a reference for a private, writable copy of the samples, for
+ *  updateBuffer(). If this was the only reference, the storage itself
+ *  just leaves the pool, with no copy. Returns NULL, still holding the
+ *  reference, if out of memory; otherwise the caller owns the result
+ *  and frees it with free().
+ */
+ALvoid *__alSamplePoolUnshare(__alSamplePool *pool,
+                              __alSharedSamples *samples);
+
+/* How many bytes of storage the pool holds, and how many it has saved. */
+void __alSamplePoolStats(__alSamplePool *pool, unsigned long long *stored,
+                         unsigned long long *saved);
+
+#endif
+
+/* end of alPool.h ... */
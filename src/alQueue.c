@@ -0,0 +1,273 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+
+#include "al.h"
+#include "alQueue.h"
+#include "alThread.h"
+
+int __alQueueInit(__alQueue *queue, ALuint capacity)
+{
+    ALuint size = 2;
+    ALuint i;
+
+    while (size < capacity)
+        size <<= 1;
+
+    queue->cells = (__alQueueCell *) malloc(sizeof (__alQueueCell) * size);
+    if (queue->cells == NULL)
+        return 0;
+
+    for (i = 0; i < size; i++)
+    {
+        queue->cells[i].sequence = i;
+        queue->cells[i].data = NULL;
+    } /* for */
+
+    queue->mask = size - 1;
+    queue->pushPos = 0;
+    queue->popPos = 0;
+    return 1;
+} /* __alQueueInit */
+
+
+void __alQueueDeinit(__alQueue *queue)
+{
+    free(queue->cells);
+    queue->cells = NULL;
+} /* __alQueueDeinit */
+
+
+int __alQueuePush(__alQueue *queue, void *data)
+{
+    ALuint pos = __alAtomicLoad(&queue->pushPos);
+
+    while (1)
+    {
+        __alQueueCell *cell = &queue->cells[pos & queue->mask];
+        const ALuint seq = __alAtomicLoad(&cell->sequence);
+        const ALint diff = (ALint) (seq - pos);
+        if (diff == 0)  /* cell is free; try to claim it. */
+        {
+            if (__alAtomicCAS(&queue->pushPos, &pos, pos + 1))
+            {
+                cell->data = data;
+                __alAtomicStore(&cell->sequence, pos + 1);
+                return 1;
+            } /* if */
+            /* lost the race; (pos) was reloaded by the CAS. */
+        } /* if */
+        else if (diff < 0)  /* not popped yet since last lap: full. */
+        {
+            return 0;
+        } /* else if */
+        else  /* someone else pushed here; catch up. */
+        {
+            pos = __alAtomicLoad(&queue->pushPos);
+        } /* else */
+    } /* while */
+} /* __alQueuePush */
+
+
+void *__alQueuePop(__alQueue *queue)
+{
+    ALuint pos = __alAtomicLoad(&queue->popPos);
+
+    while (1)
+    {
+        __alQueueCell *cell = &queue->cells[pos & queue->mask];
+        const ALuint seq = __alAtomicLoad(&cell->sequence);
+        const ALint diff = (ALint) (seq - (pos + 1));
+        if (diff == 0)  /* cell is full; try to claim it. */
+        {
+            if (__alAtomicCAS(&queue->popPos, &pos, pos + 1))
+            {
+                void *data = cell->data;
+                __alAtomicStore(&cell->sequence, pos + queue->mask + 1);
+                return data;
+            } /* if */
+        } /* if */
+        else if (diff < 0)  /* not pushed yet: empty. */
+        {
+            return NULL;
+        } /* else if */
+        else  /* someone else popped here; catch up. */
+        {
+            pos = __alAtomicLoad(&queue->popPos);
+        } /* else */
+    } /* while */
+} /* __alQueuePop */
+
+
+int __alSourceQueueInit(__alSourceQueue *queue, ALuint capacity)
+{
+    if (!__alQueueInit(&queue->pending, capacity))
+        return 0;
+    else if (!__alQueueInit(&queue->processed, capacity))
+    {
+        __alQueueDeinit(&queue->pending);
+        return 0;
+    } /* else if */
+
+    queue->capacity = capacity;
+    queue->queued = 0;
+    queue->processedCount = 0;
+    queue->current = NULL;
+    queue->cursor = 0;
+    return 1;
+} /* __alSourceQueueInit */
+
+
+void __alSourceQueueDeinit(__alSourceQueue *queue)
+{
+    __alQueueDeinit(&queue->pending);
+    __alQueueDeinit(&queue->processed);
+} /* __alSourceQueueDeinit */
+
+
+ALenum __alSourceQueueBuffers(__alSourceQueue *queue, __alBuffer **buffers,
+                              ALsizei count)
+{
+    ALuint total;
+    ALsizei i;
+
+    if (count <= 0)
+        return AL_NO_ERROR;
+
+    for (i = 0; i < count; i++)
+    {
+        /* callback and stream buffers don't end on a known frame. */
+        if ((buffers[i]->callback != NULL) || (buffers[i]->stream != NULL))
+            return AL_INVALID_OPERATION;
+    } /* for */
+
+    /*
+     * Reserve room first. Every buffer in the queue, in any state, counts
+     *  against capacity, so once the reservation succeeds, neither of the
+     *  underlying queues can be full and the pushes can't fail.
+     */
+    total = __alAtomicAdd(&queue->queued, (ALuint) count) + (ALuint) count;
+    if (total > queue->capacity)
+    {
+        __alAtomicSub(&queue->queued, (ALuint) count);
+        return AL_INVALID_OPERATION;
+    } /* if */
+
+    for (i = 0; i < count; i++)
+        __alQueuePush(&queue->pending, buffers[i]);
+
+    return AL_NO_ERROR;
+} /* __alSourceQueueBuffers */
+
+
+ALenum __alSourceQueueUnqueue(__alSourceQueue *queue, __alBuffer **buffers,
+                              ALsizei count)
+{
+    ALuint avail = __alAtomicLoad(&queue->processedCount);
+    ALsizei i;
+
+    if (count <= 0)
+        return AL_NO_ERROR;
+
+    /* claim (count) of the processed buffers, or fail without touching any. */
+    do
+    {
+        if (avail < (ALuint) count)
+            return AL_INVALID_VALUE;
+    } while (!__alAtomicCAS(&queue->processedCount, &avail,
+                            avail - (ALuint) count));
+
+    /* the mixer pushes before it bumps the count, so these are there. */
+    for (i = 0; i < count; i++)
+        buffers[i] = (__alBuffer *) __alQueuePop(&queue->processed);
+
+    __alAtomicSub(&queue->queued, (ALuint) count);
+    return AL_NO_ERROR;
+} /* __alSourceQueueUnqueue */
+
+
+ALuint __alSourceQueueQueuedCount(__alSourceQueue *queue)
+{
+    return __alAtomicLoad(&queue->queued);
+} /* __alSourceQueueQueuedCount */
+
+
+ALuint __alSourceQueueProcessedCount(__alSourceQueue *queue)
+{
+    return __alAtomicLoad(&queue->processedCount);
+} /* __alSourceQueueProcessedCount */
+
+
+static void retireCurrent(__alSourceQueue *queue)
+{
+    __alQueuePush(&queue->processed, queue->current);
+    __alAtomicAdd(&queue->processedCount, 1);
+    queue->current = NULL;
+    queue->cursor = 0;
+} /* retireCurrent */
+
+
+ALsizei __alSourceQueueSpan(__alSourceQueue *queue, __alBuffer **buffer,
+                            ALsizei *offset, ALsizei frames)
+{
+    ALsizei avail;
+
+    while (1)
+    {
+        if (queue->current == NULL)
+        {
+            queue->current = (__alBuffer *) __alQueuePop(&queue->pending);
+            queue->cursor = 0;
+            if (queue->current == NULL)
+            {
+                *buffer = NULL;
+                *offset = 0;
+                return 0;  /* starved. */
+            } /* if */
+        } /* if */
+
+        avail = queue->current->frames - queue->cursor;
+        if (avail > 0)
+            break;
+
+        retireCurrent(queue);  /* empty buffer; skip right over it. */
+    } /* while */
+
+    *buffer = queue->current;
+    *offset = queue->cursor;
+    return (avail < frames) ? avail : frames;
+} /* __alSourceQueueSpan */
+
+
+void __alSourceQueueAdvance(__alSourceQueue *queue, ALsizei frames)
+{
+    if (queue->current != NULL)
+    {
+        queue->cursor += frames;
+        if (queue->cursor >= queue->current->frames)
+            retireCurrent(queue);
+    } /* if */
+} /* __alSourceQueueAdvance */
+
+
+void __alSourceQueueFlush(__alSourceQueue *queue)
+{
+    void *buf;
+
+    if (queue->current != NULL)
+        retireCurrent(queue);
+
+    while ((buf = __alQueuePop(&queue->pending)) != NULL)
+    {
+        __alQueuePush(&queue->processed, buf);
+        __alAtomicAdd(&queue->processedCount, 1);
+    } /* while */
+} /* __alSourceQueueFlush */
+
+/* end of alQueue.c ... */
@@ -0,0 +1,124 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALQUEUE_H_
+#define _INCL_ALQUEUE_H_
+
+#include "alCore.h"
+
+/*
+ * Lock-free queues.
+ *
+ * __alQueue is a bounded queue of pointers that any number of threads may
+ *  push to and pop from at the same time, without locks (it's Dmitry
+ *  Vyukov's bounded MPMC queue: each cell carries a sequence number that
+ *  says whose turn it is to use it). Nobody ever waits on anybody else
+ *  unless the queue is full or empty, which makes it safe to touch from
+ *  the mixer thread.
+ *
+ * __alSourceQueue builds the source buffer queue (alSourceQueueBuffers()
+ *  and friends) out of two of these: one carrying buffers from the
+ *  application's threads to the mixer, and one carrying processed buffers
+ *  back. Neither direction takes the lock that guards commitSource(), so
+ *  streaming doesn't wait on state commits, and AL_BUFFERS_PROCESSED is
+ *  just an atomic load.
+ *
+ * The mixer walks the queue with __alSourceQueueSpan() and
+ *  __alSourceQueueAdvance(), which hand out contiguous spans of the
+ *  current buffer and move on to the next buffer on the exact sample
+ *  frame the current one ends, so a quantum that straddles two buffers
+ *  plays the end of one and the start of the next back to back.
+ */
+
+typedef struct S_ALQUEUECELL
+{
+    ALuint sequence;
+    void *data;
+} __alQueueCell;
+
+typedef struct S_ALQUEUE
+{
+    __alQueueCell *cells;
+    ALuint mask;
+    ALuint pushPos;
+    ALuint popPos;
+} __alQueue;
+
+/* (capacity) is rounded up to a power of two. Returns zero on failure. */
+int __alQueueInit(__alQueue *queue, ALuint capacity);
+void __alQueueDeinit(__alQueue *queue);
+
+/* Returns zero if the queue is full. Never blocks. */
+int __alQueuePush(__alQueue *queue, void *data);
+
+/* Returns NULL if the queue is empty. Never blocks. */
+void *__alQueuePop(__alQueue *queue);
+
+
+typedef struct S_ALSRCQUEUE
+{
+    __alQueue pending;       /* queued, not started yet: app -> mixer. */
+    __alQueue processed;     /* finished playing: mixer -> app. */
+    ALuint capacity;
+    ALuint queued;           /* AL_BUFFERS_QUEUED; atomic. */
+    ALuint processedCount;   /* AL_BUFFERS_PROCESSED; atomic. */
+
+    /* these belong to the mixer thread. */
+    __alBuffer *current;
+    ALsizei cursor;          /* sample frame in (current). */
+} __alSourceQueue;
+
+/* Returns zero on failure. (capacity) is the most buffers in the queue. */
+int __alSourceQueueInit(__alSourceQueue *queue, ALuint capacity);
+void __alSourceQueueDeinit(__alSourceQueue *queue);
+
+/*
+ * Application side. These may be called from any thread, at any time,
+ *  and never take a lock.
+ *
+ * Queue (count) buffers, all or nothing. Returns AL_INVALID_OPERATION if
+ *  they won't fit, AL_NO_ERROR otherwise.
+ */
+ALenum __alSourceQueueBuffers(__alSourceQueue *queue, __alBuffer **buffers,
+                              ALsizei count);
+
+/*
+ * Unqueue (count) processed buffers, oldest first, all or nothing.
+ *  Returns AL_INVALID_VALUE if fewer than (count) are processed,
+ *  AL_NO_ERROR otherwise.
+ */
+ALenum __alSourceQueueUnqueue(__alSourceQueue *queue, __alBuffer **buffers,
+                              ALsizei count);
+
+ALuint __alSourceQueueQueuedCount(__alSourceQueue *queue);
+ALuint __alSourceQueueProcessedCount(__alSourceQueue *queue);
+
+/*
+ * Mixer side. Only the mixer thread may call these.
+ *
+ * Find the next contiguous run of sample frames: sets (*buffer) and
+ *  (*offset) and returns how many frames, up to (frames), can be read
+ *  from there. Returns zero, with (*buffer) set to NULL, if the queue has
+ *  run dry.
+ */
+ALsizei __alSourceQueueSpan(__alSourceQueue *queue, __alBuffer **buffer,
+                            ALsizei *offset, ALsizei frames);
+
+/*
+ * Consume (frames) sample frames, which must be no more than the last
+ *  span handed out. If that finishes the current buffer, it moves to the
+ *  processed side right now, and the next queued buffer becomes current.
+ */
+void __alSourceQueueAdvance(__alSourceQueue *queue, ALsizei frames);
+
+/* Mark everything processed, for when the source is stopped. */
+void __alSourceQueueFlush(__alSourceQueue *queue);
+
+#endif
+
+/* end of alQueue.h ... */
@@ -0,0 +1,414 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define __AL_REVERB_SSE 1
+#endif
+
+#include "al.h"
+#include "alReverb.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SPEED_OF_SOUND 343.3f
+#define HF_REFERENCE 5000.0f
+
+/* Mutually prime-ish line lengths, in seconds, before density scaling. */
+static const ALfloat lineLengths[__AL_REVERB_LINES] =
+{
+    0.0297f, 0.0371f, 0.0411f, 0.0437f, 0.0533f, 0.0599f, 0.0679f, 0.0731f
+};
+
+/* Early reflection tap offsets, in seconds after reflectionsDelay. */
+static const ALfloat earlyOffsets[__AL_REVERB_EARLY_TAPS] =
+{
+    0.0f, 0.0071f, 0.0113f, 0.0173f
+};
+
+static const ALfloat earlyScale[__AL_REVERB_EARLY_TAPS] =
+{
+    0.5f, 0.45f, 0.35f, 0.3f
+};
+
+static const ALfloat diffuseLengths[2] = { 0.0053f, 0.0079f };
+
+/*
+ * Sign of the late reverb's input on each line; alternating signs keep
+ *  the Hadamard matrix from folding the input back into a single mode.
+ */
+static const ALfloat lineInputSign[__AL_REVERB_LINES] =
+{
+    1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f
+};
+
+
+static ALsizei nextPowerOfTwo(ALsizei val)
+{
+    ALsizei retval = 1;
+    while (retval < val)
+        retval <<= 1;
+    return retval;
+} /* nextPowerOfTwo */
+
+
+/*
+ * Coefficient for a one-pole lowpass, y = x + a*(y1 - x), that has a gain
+ *  of (gain) at the frequency with cosine (cw).
+ */
+static ALfloat lowpassCoeff(ALfloat gain, ALfloat cw)
+{
+    ALfloat g2;
+
+    if (gain >= 0.9999f)
+        return 0.0f;
+    else if (gain < 0.001f)
+        gain = 0.001f;
+
+    g2 = gain * gain;
+    return (ALfloat) ((1.0f - (g2 * cw) -
+                       sqrt((2.0f * g2 * (1.0f - cw)) -
+                            (g2 * g2 * (1.0f - (cw * cw))))) / (1.0f - g2));
+} /* lowpassCoeff */
+
+
+int __alReverbInit(__alReverb *rev, ALuint freq)
+{
+    ALsizei inputLen, lineLen, i;
+
+    memset(rev, '\0', sizeof (*rev));
+    rev->frequency = freq;
+
+    /* max reflections delay + max late delay + the early taps. */
+    inputLen = nextPowerOfTwo((ALsizei) (0.45f * (ALfloat) freq) + 1);
+    /* longest line, at maximum density. */
+    lineLen = nextPowerOfTwo((ALsizei) (0.15f * (ALfloat) freq) + 1);
+
+    rev->input = (ALfloat *) calloc(inputLen, sizeof (ALfloat));
+    rev->lines = (ALfloat *) calloc(lineLen * __AL_REVERB_LINES,
+                                    sizeof (ALfloat));
+    rev->inputMask = inputLen - 1;
+    rev->lineMask = lineLen - 1;
+
+    for (i = 0; i < 2; i++)
+    {
+        rev->diffuseLength[i] = (ALsizei) (diffuseLengths[i] * freq) + 1;
+        rev->diffuse[i] = (ALfloat *) calloc(rev->diffuseLength[i],
+                                             sizeof (ALfloat));
+        if (rev->diffuse[i] == NULL)
+            break;
+    } /* for */
+
+    if ((!rev->input) || (!rev->lines) || (i < 2))
+    {
+        __alReverbDeinit(rev);
+        return 0;
+    } /* if */
+
+    for (i = 0; i < __AL_REVERB_LINES; i++)
+        rev->lineLength[i] = 1;
+
+    return 1;
+} /* __alReverbInit */
+
+
+void __alReverbDeinit(__alReverb *rev)
+{
+    free(rev->input);
+    free(rev->lines);
+    free(rev->diffuse[0]);
+    free(rev->diffuse[1]);
+    memset(rev, '\0', sizeof (*rev));
+} /* __alReverbDeinit */
+
+
+void __alReverbClear(__alReverb *rev)
+{
+    ALsizei i;
+
+    memset(rev->input, '\0', sizeof (ALfloat) * (rev->inputMask + 1));
+    memset(rev->lines, '\0', sizeof (ALfloat) * (rev->lineMask + 1) *
+                             __AL_REVERB_LINES);
+    for (i = 0; i < 2; i++)
+    {
+        memset(rev->diffuse[i], '\0', sizeof (ALfloat) * rev->diffuseLength[i]);
+        rev->diffusePos[i] = 0;
+    } /* for */
+
+    memset(rev->lineDampState, '\0', sizeof (rev->lineDampState));
+    rev->inputHFState = 0.0f;
+} /* __alReverbClear */
+
+
+void __alReverbUpdate(__alReverb *rev, const __alReverbProperties *props,
+                      ALfloat slotGain)
+{
+    const ALfloat freq = (ALfloat) rev->frequency;
+    const ALfloat cw = (ALfloat) cos((2.0 * M_PI * HF_REFERENCE) / freq);
+    const ALfloat lengthScale = 1.0f + props->density;
+    const ALfloat gain = props->gain * slotGain;
+    ALfloat hfRatio = props->decayHFRatio;
+    ALsizei i;
+
+    /*
+     * With decayHFLimit set, high frequencies can't ring longer than air
+     *  absorption would allow over the distance sound travels in decayTime.
+     */
+    if ((props->decayHFLimit) && (props->airAbsorptionGainHF < 1.0f))
+    {
+        const ALfloat limit = (ALfloat) (-3.0 /
+                        (log10(props->airAbsorptionGainHF) * SPEED_OF_SOUND));
+        if ((hfRatio * props->decayTime) > limit)
+            hfRatio = limit / props->decayTime;
+    } /* if */
+
+    for (i = 0; i < __AL_REVERB_EARLY_TAPS; i++)
+    {
+        const ALfloat delay = props->reflectionsDelay +
+                              (earlyOffsets[i] * lengthScale);
+        rev->earlyTap[i] = (ALsizei) (delay * freq);
+        rev->earlyGain[i] = props->reflectionsGain * gain * earlyScale[i];
+    } /* for */
+
+    rev->lateTap = (ALsizei) ((props->reflectionsDelay +
+                               props->lateReverbDelay) * freq);
+    rev->lateGain = props->lateReverbGain * gain * 0.5f;
+
+    for (i = 0; i < __AL_REVERB_LINES; i++)
+    {
+        const ALsizei len = (ALsizei) (lineLengths[i] * lengthScale * freq);
+        const ALfloat seconds = ((ALfloat) len) / freq;
+        const ALfloat decay = (ALfloat) pow(10.0, (-3.0 * seconds) /
+                                                  props->decayTime);
+        const ALfloat decayHF = (ALfloat) pow(10.0, (-3.0 * seconds) /
+                                         (props->decayTime * hfRatio));
+        rev->lineLength[i] = (len > 0) ? len : 1;
+        rev->lineDecay[i] = decay;
+        rev->lineDampCoeff[i] = lowpassCoeff(decayHF / decay, cw);
+    } /* for */
+
+    rev->inputHFCoeff = lowpassCoeff(props->gainHF, cw);
+    rev->diffuseCoeff = 0.6f * props->diffusion;
+} /* __alReverbUpdate */
+
+
+/* Schroeder allpass, to smear the late reverb's input. */
+static ALfloat diffuse(__alReverb *rev, int which, ALfloat x)
+{
+    const ALfloat g = rev->diffuseCoeff;
+    ALfloat *line = rev->diffuse[which];
+    const ALsizei pos = rev->diffusePos[which];
+    const ALfloat delayed = line[pos];
+    const ALfloat v = x - (g * delayed);
+
+    line[pos] = v;
+    rev->diffusePos[which] = ((pos + 1) == rev->diffuseLength[which]) ?
+                                0 : (pos + 1);
+    return delayed + (g * v);
+} /* diffuse */
+
+
+#if __AL_REVERB_SSE
+/* 4 point Hadamard transform, unscaled. */
+static __m128 hadamard4(__m128 x)
+{
+    const __m128 sign1 = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    const __m128 sign2 = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+    __m128 y;
+
+    y = _mm_add_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 0, 0)),
+                   _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 1, 1)),
+                              sign1));
+    return _mm_add_ps(_mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 0, 1, 0)),
+                      _mm_mul_ps(_mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 2, 3, 2)),
+                                 sign2));
+} /* hadamard4 */
+
+
+static void runLate(__alReverb *rev, const ALfloat *lateIn,
+                    ALfloat *output, ALsizei frames)
+{
+    const __m128 scale = _mm_set1_ps(0.35355339f);  /* 1/sqrt(8) */
+    const __m128 decay0 = _mm_loadu_ps(rev->lineDecay);
+    const __m128 decay1 = _mm_loadu_ps(rev->lineDecay + 4);
+    const __m128 coeff0 = _mm_loadu_ps(rev->lineDampCoeff);
+    const __m128 coeff1 = _mm_loadu_ps(rev->lineDampCoeff + 4);
+    const __m128 sign0 = _mm_loadu_ps(lineInputSign);
+    const __m128 sign1 = _mm_loadu_ps(lineInputSign + 4);
+    const __m128 lateGain = _mm_set1_ps(rev->lateGain);
+    const ALsizei *len = rev->lineLength;
+    const ALsizei mask = rev->lineMask;
+    ALfloat *lines = rev->lines;
+    ALsizei pos = rev->linePos;
+    __m128 state0 = _mm_loadu_ps(rev->lineDampState);
+    __m128 state1 = _mm_loadu_ps(rev->lineDampState + 4);
+    ALsizei i;
+
+    for (i = 0; i < frames; i++)
+    {
+        const __m128 in = _mm_set1_ps(lateIn[i]);
+        __m128 tap0, tap1, sum, a, b;
+
+        /* the only part that can't be done four lines at a time. */
+        tap0 = _mm_setr_ps(lines[(((pos - len[0]) & mask) * 8) + 0],
+                           lines[(((pos - len[1]) & mask) * 8) + 1],
+                           lines[(((pos - len[2]) & mask) * 8) + 2],
+                           lines[(((pos - len[3]) & mask) * 8) + 3]);
+        tap1 = _mm_setr_ps(lines[(((pos - len[4]) & mask) * 8) + 4],
+                           lines[(((pos - len[5]) & mask) * 8) + 5],
+                           lines[(((pos - len[6]) & mask) * 8) + 6],
+                           lines[(((pos - len[7]) & mask) * 8) + 7]);
+
+        /* HF damping, then decay. */
+        state0 = _mm_add_ps(tap0, _mm_mul_ps(coeff0, _mm_sub_ps(state0, tap0)));
+        state1 = _mm_add_ps(tap1, _mm_mul_ps(coeff1, _mm_sub_ps(state1, tap1)));
+        tap0 = _mm_mul_ps(state0, decay0);
+        tap1 = _mm_mul_ps(state1, decay1);
+
+        /* even lines go left, odd lines go right. */
+        sum = _mm_add_ps(tap0, tap1);
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_mul_ps(sum, lateGain);
+        _mm_storel_pi((__m64 *) (output + (i * 2)),
+            _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(),
+                                    (const __m64 *) (output + (i * 2))), sum));
+
+        /* 8 point Hadamard feedback: one butterfly, then two 4 pointers. */
+        a = hadamard4(_mm_add_ps(tap0, tap1));
+        b = hadamard4(_mm_sub_ps(tap0, tap1));
+        a = _mm_add_ps(_mm_mul_ps(a, scale), _mm_mul_ps(in, sign0));
+        b = _mm_add_ps(_mm_mul_ps(b, scale), _mm_mul_ps(in, sign1));
+        _mm_storeu_ps(lines + (pos * 8), a);
+        _mm_storeu_ps(lines + (pos * 8) + 4, b);
+
+        pos = (pos + 1) & mask;
+    } /* for */
+
+    _mm_storeu_ps(rev->lineDampState, state0);
+    _mm_storeu_ps(rev->lineDampState + 4, state1);
+    rev->linePos = pos;
+} /* runLate */
+
+#else
+
+static void hadamard4(ALfloat *x)
+{
+    const ALfloat a = x[0] + x[1];
+    const ALfloat b = x[0] - x[1];
+    const ALfloat c = x[2] + x[3];
+    const ALfloat d = x[2] - x[3];
+    x[0] = a + c;
+    x[1] = b + d;
+    x[2] = a - c;
+    x[3] = b - d;
+} /* hadamard4 */
+
+
+static void runLate(__alReverb *rev, const ALfloat *lateIn,
+                    ALfloat *output, ALsizei frames)
+{
+    const ALfloat scale = 0.35355339f;  /* 1/sqrt(8) */
+    const ALsizei *len = rev->lineLength;
+    const ALsizei mask = rev->lineMask;
+    ALfloat *state = rev->lineDampState;
+    ALfloat *lines = rev->lines;
+    ALsizei pos = rev->linePos;
+    ALfloat tap[__AL_REVERB_LINES];
+    ALfloat a[4], b[4];
+    ALsizei i, j;
+
+    for (i = 0; i < frames; i++)
+    {
+        ALfloat *dst = lines + (pos * 8);
+        ALfloat left = 0.0f;
+        ALfloat right = 0.0f;
+
+        for (j = 0; j < __AL_REVERB_LINES; j++)
+        {
+            const ALfloat x = lines[(((pos - len[j]) & mask) * 8) + j];
+            state[j] = x + (rev->lineDampCoeff[j] * (state[j] - x));
+            tap[j] = state[j] * rev->lineDecay[j];
+            if (j & 1)
+                right += tap[j];
+            else
+                left += tap[j];
+        } /* for */
+
+        output[(i * 2) + 0] += left * rev->lateGain;
+        output[(i * 2) + 1] += right * rev->lateGain;
+
+        for (j = 0; j < 4; j++)
+        {
+            a[j] = tap[j] + tap[j + 4];
+            b[j] = tap[j] - tap[j + 4];
+        } /* for */
+        hadamard4(a);
+        hadamard4(b);
+
+        for (j = 0; j < 4; j++)
+        {
+            dst[j] = (a[j] * scale) + (lateIn[i] * lineInputSign[j]);
+            dst[j + 4] = (b[j] * scale) + (lateIn[i] * lineInputSign[j + 4]);
+        } /* for */
+
+        pos = (pos + 1) & mask;
+    } /* for */
+
+    rev->linePos = pos;
+} /* runLate */
+#endif
+
+
+void __alReverbProcess(__alReverb *rev, const ALfloat *input,
+                       ALfloat *output, ALsizei frames)
+{
+    const ALsizei mask = rev->inputMask;
+    ALfloat lateIn[256];
+    ALsizei done = 0;
+
+    /* work in small chunks so the late input fits on the stack. */
+    while (done < frames)
+    {
+        const ALsizei chunk = ((frames - done) > 256) ? 256 : (frames - done);
+        ALfloat *out = output + (done * 2);
+        ALsizei i, j;
+
+        for (i = 0; i < chunk; i++)
+        {
+            ALsizei pos = rev->inputPos;
+            ALfloat x = input[done + i];
+
+            /* gainHF */
+            x = x + (rev->inputHFCoeff * (rev->inputHFState - x));
+            rev->inputHFState = x;
+            rev->input[pos] = x;
+
+            /* early reflections alternate between the left and right. */
+            for (j = 0; j < __AL_REVERB_EARLY_TAPS; j++)
+            {
+                out[(i * 2) + (j & 1)] += rev->earlyGain[j] *
+                                 rev->input[(pos - rev->earlyTap[j]) & mask];
+            } /* for */
+
+            x = rev->input[(pos - rev->lateTap) & mask];
+            lateIn[i] = diffuse(rev, 1, diffuse(rev, 0, x));
+            rev->inputPos = (pos + 1) & mask;
+        } /* for */
+
+        runLate(rev, lateIn, out, chunk);
+        done += chunk;
+    } /* while */
+} /* __alReverbProcess */
+
+/* end of alReverb.c ... */
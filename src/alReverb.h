@@ -0,0 +1,96 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALREVERB_H_
+#define _INCL_ALREVERB_H_
+
+#include "alCore.h"
+
+/*
+ * The software mixer's reverb, for auxiliary effect slots running an
+ *  AL_EFFECT_REVERB (see __alEffectSlot in alCore.h).
+ *
+ * This runs once per slot per quantum, over the sum of every source sent
+ *  to the slot; a source never pays for more than the one multiply-add it
+ *  takes to get into the slot's input buffer.
+ *
+ * The reverb is a handful of early reflection taps off an input delay
+ *  line, followed by an eight line feedback delay network for the late
+ *  reverb. The delay lines are stored interleaved (eight floats per sample
+ *  frame), so the whole network advances one sample at a time as two
+ *  4-wide vectors: damping, decay, the Hadamard feedback matrix and the
+ *  write back are all SIMD, and only the reads, where each line has a
+ *  different length, are done per line.
+ *
+ * Lines get a one-pole lowpass in the feedback path so high frequencies
+ *  decay at decayTime * decayHFRatio, which is what makes it sound like a
+ *  room instead of a spring.
+ */
+
+#define __AL_REVERB_LINES 8
+#define __AL_REVERB_EARLY_TAPS 4
+
+typedef struct S_ALREVERB
+{
+    ALuint frequency;
+
+    /* input delay line, for reflections delay and late reverb delay. */
+    ALfloat *input;
+    ALsizei inputMask;
+    ALsizei inputPos;
+
+    /* late reverb network; (lineMask+1) frames of eight interleaved lines. */
+    ALfloat *lines;
+    ALsizei lineMask;
+    ALsizei linePos;
+
+    /* everything below is recalculated by __alReverbUpdate(). */
+    ALsizei earlyTap[__AL_REVERB_EARLY_TAPS];
+    ALfloat earlyGain[__AL_REVERB_EARLY_TAPS];
+    ALsizei lateTap;
+    ALsizei lineLength[__AL_REVERB_LINES];
+    ALfloat lineDecay[__AL_REVERB_LINES];    /* feedback gain per line. */
+    ALfloat lineDampCoeff[__AL_REVERB_LINES];
+    ALfloat lineDampState[__AL_REVERB_LINES];
+    ALfloat lateGain;
+    ALfloat inputHFCoeff;                    /* gainHF lowpass. */
+    ALfloat inputHFState;
+    ALfloat diffuseCoeff;
+    ALsizei diffuseLength[2];
+    ALfloat *diffuse[2];                     /* allpass diffuser lines. */
+    ALsizei diffusePos[2];
+} __alReverb;
+
+/*
+ * Allocate delay lines for a reverb running at (freq). Everything is sized
+ *  for the worst case allowed by EFX, so parameter changes never
+ *  allocate. Returns non-zero on success, zero if out of memory.
+ */
+int __alReverbInit(__alReverb *rev, ALuint freq);
+void __alReverbDeinit(__alReverb *rev);
+
+/* Silence all delay lines, for when the slot's effect is (re)attached. */
+void __alReverbClear(__alReverb *rev);
+
+/*
+ * Recalculate coefficients from (props) and the effect slot's gain. This
+ *  is meant to be called from commitEffectSlot(), not while rendering.
+ */
+void __alReverbUpdate(__alReverb *rev, const __alReverbProperties *props,
+                      ALfloat slotGain);
+
+/*
+ * Run (frames) samples of the slot's summed mono (input) through the
+ *  reverb, adding the result to (output), which is interleaved stereo.
+ */
+void __alReverbProcess(__alReverb *rev, const ALfloat *input,
+                       ALfloat *output, ALsizei frames);
+
+#endif
+
+/* end of alReverb.h ... */
@@ -0,0 +1,304 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(SYS_memfd_create)
+#define __AL_RING_MIRROR 1
+#endif
+#endif
+
+#include "al.h"
+#include "alRing.h"
+#include "alThread.h"
+
+/* positions wrap at 2^32, so the capacity has to stay well under that. */
+#define MAX_CAPACITY 0x40000000
+
+#if __AL_RING_MIRROR
+/*
+ * Map one memfd twice, back to back. The whole range is reserved first,
+ *  so nothing else can land in the second half between the two mmap()s.
+ */
+static ALubyte *mapMirror(ALuint size)
+{
+    const int fd = (int) syscall(SYS_memfd_create, "ioal-ring", 0);
+    ALubyte *base;
+
+    if (fd == -1)
+        return NULL;
+    else if (ftruncate(fd, (off_t) size) == -1)
+    {
+        close(fd);
+        return NULL;
+    } /* else if */
+
+    base = (ALubyte *) mmap(NULL, (size_t) size * 2, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == (ALubyte *) MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    } /* if */
+
+    if ( (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+               fd, 0) == MAP_FAILED) ||
+         (mmap(base + size, size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) )
+    {
+        munmap(base, (size_t) size * 2);
+        close(fd);
+        return NULL;
+    } /* if */
+
+    close(fd);  /* the mappings keep it alive. */
+    return base;
+} /* mapMirror */
+#endif
+
+
+int __alRingInit(__alRing *ring, ALuint bytes)
+{
+    ALuint size = 16;
+
+    memset(ring, '\0', sizeof (__alRing));
+    if (bytes > MAX_CAPACITY)
+        return 0;
+
+    while (size < bytes)
+        size <<= 1;
+
+    ring->claimed = ring->readers = 1;  /* reader zero. */
+
+    #if __AL_RING_MIRROR
+    {
+        /* pages are a power of two too, so this stays one. */
+        const long pagesize = sysconf(_SC_PAGESIZE);
+        ALuint mapsize = size;
+        while ((pagesize > 0) && (mapsize < (ALuint) pagesize))
+            mapsize <<= 1;
+
+        ring->buffer = mapMirror(mapsize);
+        if (ring->buffer != NULL)
+        {
+            ring->capacity = mapsize;
+            ring->mirrored = AL_TRUE;
+            return 1;
+        } /* if */
+    }
+    #endif
+
+    ring->buffer = (ALubyte *) malloc(size);
+    if (ring->buffer == NULL)
+        return 0;
+
+    ring->capacity = size;
+    ring->mirrored = AL_FALSE;
+    return 1;
+} /* __alRingInit */
+
+
+void __alRingDeinit(__alRing *ring)
+{
+    #if __AL_RING_MIRROR
+    if (ring->mirrored)
+        munmap(ring->buffer, (size_t) ring->capacity * 2);
+    else
+    #endif
+        free(ring->buffer);
+
+    memset(ring, '\0', sizeof (__alRing));
+} /* __alRingDeinit */
+
+
+/*
+ * Bytes held for the slowest reader. Each cursor is read before the write
+ *  position, so a reader moving along meanwhile can't make it negative.
+ *  A reader that's just been added may briefly have a cursor more than a
+ *  ring behind (see __alRingAddReader()), so this never says more than
+ *  the capacity; that just means no space is free until it catches up.
+ */
+static ALuint held(__alRing *ring)
+{
+    const ALuint readers = __alAtomicLoad(&ring->readers);
+    ALuint retval = 0;
+    ALint i;
+
+    for (i = 0; i < __AL_RING_READERS; i++)
+    {
+        if (readers & (1 << i))
+        {
+            const ALuint readPos = __alAtomicLoad(&ring->readPos[i]);
+            const ALuint used = __alAtomicLoad(&ring->writePos) - readPos;
+            if (used > retval)
+                retval = used;
+        } /* if */
+    } /* for */
+
+    return (retval > ring->capacity) ? ring->capacity : retval;
+} /* held */
+
+
+ALint __alRingAddReader(__alRing *ring)
+{
+    ALuint claimed = __alAtomicLoad(&ring->claimed);
+    ALuint readers;
+    ALint i;
+
+    /* take a free slot... */
+    do
+    {
+        for (i = 0; i < __AL_RING_READERS; i++)
+        {
+            if ((claimed & (1 << i)) == 0)
+                break;
+        } /* for */
+
+        if (i == __AL_RING_READERS)
+            return -1;
+    } while (!__alAtomicCAS(&ring->claimed, &claimed, claimed | (1 << i)));
+
+    /*
+     * ...point it at the newest data, then let the producer see it. The
+     *  producer may write more before it notices the new reader, so by
+     *  the time it does, that cursor can be any distance behind, more
+     *  than a ring's worth included; held() caps it, which just stops the
+     *  producer for a moment. So once it's published, point it at the
+     *  newest data again: anything written before then is behind it, and
+     *  a write already under way goes past it, so it never reads space
+     *  the producer took back.
+     */
+    __alAtomicStore(&ring->readPos[i], __alAtomicLoad(&ring->writePos));
+    readers = __alAtomicLoad(&ring->readers);
+    while (!__alAtomicCAS(&ring->readers, &readers, readers | (1 << i)))
+        /* (readers) was reloaded; try again. */ ;
+    __alAtomicStore(&ring->readPos[i], __alAtomicLoad(&ring->writePos));
+
+    return i;
+} /* __alRingAddReader */
+
+
+void __alRingRemoveReader(__alRing *ring, ALint reader)
+{
+    ALuint mask;
+
+    if ((reader <= 0) || (reader >= __AL_RING_READERS))
+        return;  /* reader zero stays. */
+
+    mask = __alAtomicLoad(&ring->readers);
+    while (!__alAtomicCAS(&ring->readers, &mask, mask & ~(1 << reader)))
+        /* (mask) was reloaded; try again. */ ;
+
+    mask = __alAtomicLoad(&ring->claimed);
+    while (!__alAtomicCAS(&ring->claimed, &mask, mask & ~(1 << reader)))
+        /* (mask) was reloaded; try again. */ ;
+} /* __alRingRemoveReader */
+
+
+ALubyte *__alRingWriteSpan(__alRing *ring, ALuint *avail)
+{
+    const ALuint offset = ring->writePos & (ring->capacity - 1);  /* ours. */
+    ALuint space = ring->capacity - held(ring);
+
+    if ((!ring->mirrored) && (space > (ring->capacity - offset)))
+        space = ring->capacity - offset;
+
+    *avail = space;
+    return ring->buffer + offset;
+} /* __alRingWriteSpan */
+
+
+void __alRingCommit(__alRing *ring, ALuint bytes)
+{
+    /* release: the data is in place before the readers can see it. */
+    __alAtomicStore(&ring->writePos, ring->writePos + bytes);
+} /* __alRingCommit */
+
+
+ALuint __alRingWritable(__alRing *ring)
+{
+    return ring->capacity - held(ring);
+} /* __alRingWritable */
+
+
+void __alRingWrite(__alRing *ring, const ALvoid *src, ALuint bytes)
+{
+    const ALubyte *in = (const ALubyte *) src;
+
+    while (bytes > 0)
+    {
+        ALuint avail;
+        ALubyte *span = __alRingWriteSpan(ring, &avail);
+        if (avail > bytes)
+            avail = bytes;
+        memcpy(span, in, avail);
+        __alRingCommit(ring, avail);
+        in += avail;
+        bytes -= avail;
+    } /* while */
+} /* __alRingWrite */
+
+
+ALuint __alRingFill(__alRing *ring)
+{
+    return held(ring);
+} /* __alRingFill */
+
+
+const ALubyte *__alRingReadSpan(__alRing *ring, ALint reader, ALuint *avail)
+{
+    const ALuint readPos = ring->readPos[reader];  /* ours. */
+    const ALuint writePos = __alAtomicLoad(&ring->writePos);
+    const ALuint offset = readPos & (ring->capacity - 1);
+    ALuint ready = writePos - readPos;
+
+    if ((!ring->mirrored) && (ready > (ring->capacity - offset)))
+        ready = ring->capacity - offset;
+
+    *avail = ready;
+    return ring->buffer + offset;
+} /* __alRingReadSpan */
+
+
+void __alRingRelease(__alRing *ring, ALint reader, ALuint bytes)
+{
+    __alAtomicStore(&ring->readPos[reader], ring->readPos[reader] + bytes);
+} /* __alRingRelease */
+
+
+ALuint __alRingReadable(__alRing *ring, ALint reader)
+{
+    const ALuint readPos = __alAtomicLoad(&ring->readPos[reader]);
+    return __alAtomicLoad(&ring->writePos) - readPos;
+} /* __alRingReadable */
+
+
+void __alRingRead(__alRing *ring, ALint reader, ALvoid *dst, ALuint bytes)
+{
+    ALubyte *out = (ALubyte *) dst;
+
+    /* once if mirrored, at most twice if not. */
+    while (bytes > 0)
+    {
+        ALuint avail;
+        const ALubyte *span = __alRingReadSpan(ring, reader, &avail);
+        if (avail > bytes)
+            avail = bytes;
+        memcpy(out, span, avail);
+        __alRingRelease(ring, reader, avail);
+        out += avail;
+        bytes -= avail;
+    } /* while */
+} /* __alRingRead */
+
+/* end of alRing.c ... */
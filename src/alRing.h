@@ -0,0 +1,114 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALRING_H_
+#define _INCL_ALRING_H_
+
+#include "alCore.h"
+
+/*
+ * A lock-free ring of bytes, with one producer and up to
+ *  __AL_RING_READERS consumers.
+ *
+ * Capture uses this between the thread pumping the device and the
+ *  application calling alcCaptureSamples(). Each side owns its position
+ *  and only reads the others', so nobody ever waits for anybody else.
+ *  Every reader has its own cursor and sees every byte; the producer
+ *  only reuses space once the slowest of them is done with it. Positions
+ *  count bytes forever and wrap at 2^32, which is fine since the capacity
+ *  is a power of two.
+ *
+ * Reader zero is always there. More can come and go while the ring is in
+ *  use; a new reader starts at the newest data, so it only sees what's
+ *  written after it joined.
+ *
+ * Where we can, the ring's memory is mapped twice, back to back (a memfd
+ *  and two mmap()s, on Linux), so the byte after the last one is the
+ *  first one again. That means any run of free space or data is one
+ *  contiguous span, however it straddles the end: the device writes
+ *  straight into the ring, and readers copy out of it in one go, with no
+ *  splitting. Where we can't, spans stop at the end of the buffer and the
+ *  copies come in two pieces; everything still works, it's just a little
+ *  slower.
+ */
+
+#define __AL_RING_READERS __AL_MAX_CAPTURE_READERS  /* capture's the user. */
+
+typedef struct S_ALRING
+{
+    ALubyte *buffer;
+    ALuint capacity;          /* bytes; a power of two. */
+    ALboolean mirrored;       /* mapped twice; spans never split. */
+    ALuint writePos;          /* producer's; atomic. */
+    ALuint claimed;           /* atomic; bit per reader slot taken. */
+    ALuint readers;           /* atomic; bit per reader the producer honors. */
+    ALuint readPos[__AL_RING_READERS];  /* each reader's own; atomic. */
+} __alRing;
+
+/*
+ * Make a ring that holds at least (bytes), rounded up to a power of two
+ *  (and a whole number of pages, if it's mirrored), with just reader zero.
+ *  Returns zero on failure.
+ */
+int __alRingInit(__alRing *ring, ALuint bytes);
+void __alRingDeinit(__alRing *ring);
+
+/*
+ * Add a reader, starting at the newest data. Returns its number, or -1 if
+ *  they're all taken. Any thread may add or remove readers.
+ */
+ALint __alRingAddReader(__alRing *ring);
+
+/* Drop a reader other than zero; the space it held is free right away. */
+void __alRingRemoveReader(__alRing *ring, ALint reader);
+
+/*
+ * Producer side. Get a pointer to free space, with (*avail) set to how
+ *  many bytes can be written there in one go, then commit however many
+ *  were actually written. (*avail) is all the free space if the ring is
+ *  mirrored.
+ */
+ALubyte *__alRingWriteSpan(__alRing *ring, ALuint *avail);
+void __alRingCommit(__alRing *ring, ALuint bytes);
+
+/* Free bytes, contiguous or not. Producer side. */
+ALuint __alRingWritable(__alRing *ring);
+
+/*
+ * Copy (bytes) from (src) into the ring and commit them. There must be
+ *  that much free space.
+ */
+void __alRingWrite(__alRing *ring, const ALvoid *src, ALuint bytes);
+
+/*
+ * Bytes held for the slowest reader; the capacity less this is free.
+ *  Anyone may ask.
+ */
+ALuint __alRingFill(__alRing *ring);
+
+/*
+ * Consumer side; each reader is one thread at a time. Get a pointer to
+ *  the reader's oldest data, with (*avail) set to how many bytes can be
+ *  read there in one go, then release however many were used. The span
+ *  stays valid until it's released.
+ */
+const ALubyte *__alRingReadSpan(__alRing *ring, ALint reader, ALuint *avail);
+void __alRingRelease(__alRing *ring, ALint reader, ALuint bytes);
+
+/* Bytes waiting for (reader). Anyone may ask. */
+ALuint __alRingReadable(__alRing *ring, ALint reader);
+
+/*
+ * Copy (bytes) out of the ring into (dst) and release them. There must
+ *  be that many readable.
+ */
+void __alRingRead(__alRing *ring, ALint reader, ALvoid *dst, ALuint bytes);
+
+#endif
+
+/* end of alRing.h ... */
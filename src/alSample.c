@@ -0,0 +1,487 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <string.h>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#define __AL_SAMPLE_F16C 1
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define __AL_SAMPLE_SSSE3 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define __AL_SAMPLE_SSE2 1
+#endif
+
+#include "al.h"
+#include "alSample.h"
+
+#define INT16_SCALE 32768.0f
+#define INT24_SCALE 8388608.0f
+#define STAGING_SAMPLES 256
+
+/*
+ * Samples per piece for __alSampleImportParallel(): a megabyte of float
+ *  output, big enough that handing it off is noise, small enough that
+ *  every core gets a few on a long sound.
+ */
+#define PARALLEL_SAMPLES (256 * 1024)
+
+
+ALsizei __alSampleSize(ALenum storage)
+{
+    switch (storage)
+    {
+        case AL_STORAGE_FLOAT32_IOAL: return 4;
+        case AL_STORAGE_INT16_IOAL: return 2;
+        case AL_STORAGE_FLOAT16_IOAL: return 2;
+        case AL_STORAGE_INT24_IOAL: return 3;
+    } /* switch */
+
+    return 0;
+} /* __alSampleSize */
+
+
+static ALuint floatBits(ALfloat f)
+{
+    ALuint retval;
+    memcpy(&retval, &f, sizeof (retval));
+    return retval;
+} /* floatBits */
+
+
+static ALfloat bitsFloat(ALuint bits)
+{
+    ALfloat retval;
+    memcpy(&retval, &bits, sizeof (retval));
+    return retval;
+} /* bitsFloat */
+
+
+static ALfloat halfToFloat(ALushort h)
+{
+    const ALuint sign = ((ALuint) (h & 0x8000)) << 16;
+    const ALuint exponent = (h >> 10) & 0x1F;
+    const ALuint mantissa = h & 0x3FF;
+
+    if (exponent == 0)  /* zero or subnormal: mantissa * 2^-24, exactly. */
+    {
+        const ALfloat f = ((ALfloat) mantissa) * (1.0f / 16777216.0f);
+        return sign ? -f : f;
+    } /* if */
+    else if (exponent == 31)  /* inf, or nan (quieted, like F16C does). */
+    {
+        const ALuint quiet = (mantissa != 0) ? 0x00400000 : 0;
+        return bitsFloat(sign | 0x7F800000 | quiet | (mantissa << 13));
+    } /* else if */
+
+    return bitsFloat(sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13));
+} /* halfToFloat */
+
+
+/*
+ * Round to nearest, ties to even, the same as F16C does, so stored data
+ *  doesn't depend on which path wrote it.
+ */
+static ALushort floatToHalf(ALfloat f)
+{
+    const ALuint bits = floatBits(f);
+    const ALushort sign = (ALushort) ((bits >> 16) & 0x8000);
+    ALuint absbits = bits & 0x7FFFFFFF;
+
+    if (absbits >= 0x7F800000)  /* inf stays inf, nan stays (quiet) nan. */
+    {
+        if (absbits == 0x7F800000)
+            return sign | 0x7C00;
+        return (ALushort) (sign | 0x7E00 | ((absbits >> 13) & 0x3FF));
+    } /* if */
+    else if (absbits >= 0x477FF000)  /* rounds up past 65504. */
+        return sign | 0x7C00;
+    else if (absbits < 0x38800000)  /* subnormal in half. */
+    {
+        /*
+         * Adding 0.5 lines the half's subnormal steps up with the float's
+         *  last mantissa bit, so the FPU does the rounding for us.
+         */
+        const ALfloat magic = 0.5f;
+        const ALuint rounded = floatBits(bitsFloat(absbits) + magic);
+        return (ALushort) (sign | (rounded - floatBits(magic)));
+    } /* else if */
+
+    /* rebias the exponent, then round on the 13 bits we drop. */
+    absbits += ((ALuint) (15 - 127) << 23) + 0xFFF + ((absbits >> 13) & 1);
+    return (ALushort) (sign | (absbits >> 13));
+} /* floatToHalf */
+
+
+static ALint roundClamp(ALfloat f, ALfloat scale)
+{
+    ALfloat v = f * scale;
+    if (v >= scale - 1.0f)
+        return (ALint) (scale - 1.0f);
+    else if (v <= -scale)
+        return (ALint) -scale;
+    else if (v != v)  /* nan. */
+        return 0;
+    return (ALint) ((v < 0.0f) ? (v - 0.5f) : (v + 0.5f));
+} /* roundClamp */
+
+
+void __alSampleEncode(ALenum storage, ALvoid *dst, const ALfloat *src,
+                      ALsizei samples)
+{
+    ALsizei i = 0;
+
+    switch (storage)
+    {
+        case AL_STORAGE_FLOAT32_IOAL:
+            memcpy(dst, src, samples * sizeof (ALfloat));
+            break;
+
+        case AL_STORAGE_INT16_IOAL:
+        {
+            ALshort *out = (ALshort *) dst;
+            for (i = 0; i < samples; i++)
+                out[i] = (ALshort) roundClamp(src[i], INT16_SCALE);
+            break;
+        } /* case */
+
+        case AL_STORAGE_FLOAT16_IOAL:
+        {
+            ALushort *out = (ALushort *) dst;
+            #if __AL_SAMPLE_F16C
+            for (; (i + 4) <= samples; i += 4)
+            {
+                const __m128i h = _mm_cvtps_ph(_mm_loadu_ps(src + i),
+                                               _MM_FROUND_TO_NEAREST_INT);
+                _mm_storel_epi64((__m128i *) (out + i), h);
+            } /* for */
+            #endif
+            for (; i < samples; i++)
+                out[i] = floatToHalf(src[i]);
+            break;
+        } /* case */
+
+        case AL_STORAGE_INT24_IOAL:
+        {
+            ALubyte *out = (ALubyte *) dst;
+            for (i = 0; i < samples; i++, out += 3)
+            {
+                const ALint v = roundClamp(src[i], INT24_SCALE);
+                out[0] = (ALubyte) (v & 0xFF);
+                out[1] = (ALubyte) ((v >> 8) & 0xFF);
+                out[2] = (ALubyte) ((v >> 16) & 0xFF);
+            } /* for */
+            break;
+        } /* case */
+    } /* switch */
+} /* __alSampleEncode */
+
+
+int __alSampleImport(ALenum storage, ALvoid *dst, ALenum fmt,
+                     const ALvoid *src, ALsizei samples)
+{
+    const ALsizei size = __alSampleSize(storage);
+    ALfloat staging[STAGING_SAMPLES];
+    ALubyte *out = (ALubyte *) dst;
+    ALboolean is8bit;
+    ALsizei i;
+
+    if (size == 0)
+        return 0;
+
+    switch (fmt)
+    {
+        case AL_FORMAT_MONO8: case AL_FORMAT_STEREO8:
+            is8bit = AL_TRUE;
+            break;
+        case AL_FORMAT_MONO16: case AL_FORMAT_STEREO16:
+            is8bit = AL_FALSE;
+            break;
+        default:
+            return 0;
+    } /* switch */
+
+    if ((!is8bit) && (storage == AL_STORAGE_INT16_IOAL))
+    {
+        memcpy(dst, src, samples * sizeof (ALshort));  /* already there. */
+        return 1;
+    } /* if */
+
+    /* everything else goes through float, a cache-friendly run at a time. */
+    while (samples > 0)
+    {
+        const ALsizei count = (samples < STAGING_SAMPLES) ?
+                                samples : STAGING_SAMPLES;
+        ALfloat *f = (storage == AL_STORAGE_FLOAT32_IOAL) ?
+                        (ALfloat *) out : staging;
+
+        if (is8bit)
+        {
+            const ALubyte *in = (const ALubyte *) src;
+            for (i = 0; i < count; i++)
+                f[i] = ((ALfloat) (((ALint) in[i]) - 128)) * (1.0f / 128.0f);
+            src = in + count;
+        } /* if */
+        else
+        {
+            const ALshort *in = (const ALshort *) src;
+            for (i = 0; i < count; i++)
+                f[i] = ((ALfloat) in[i]) * (1.0f / INT16_SCALE);
+            src = in + count;
+        } /* else */
+
+        if (f == staging)
+            __alSampleEncode(storage, out, staging, count);
+
+        out += count * size;
+        samples -= count;
+    } /* while */
+
+    return 1;
+} /* __alSampleImport */
+
+
+typedef struct S_ALPARALLELIMPORT
+{
+    ALenum storage;
+    ALubyte *dst;
+    ALenum fmt;
+    const ALubyte *src;
+    ALsizei samples;
+    ALsizei inSize;          /* bytes per input sample. */
+    ALsizei outSize;         /* bytes per stored sample. */
+} __alParallelImport;
+
+
+static void importPiece(void *data, ALsizei index)
+{
+    const __alParallelImport *job = (const __alParallelImport *) data;
+    const ALsizei first = index * PARALLEL_SAMPLES;
+    ALsizei count = job->samples - first;
+
+    if (count > PARALLEL_SAMPLES)
+        count = PARALLEL_SAMPLES;
+
+    __alSampleImport(job->storage, job->dst + (first * job->outSize),
+                     job->fmt, job->src + (first * job->inSize), count);
+} /* importPiece */
+
+
+int __alSampleImportParallel(__alWorkerPool *pool, ALenum storage,
+                             ALvoid *dst, ALenum fmt, const ALvoid *src,
+                             ALsizei samples)
+{
+    __alParallelImport job;
+
+    if (samples < (PARALLEL_SAMPLES * 2))
+        return __alSampleImport(storage, dst, fmt, src, samples);
+    else if (!__alSampleImport(storage, dst, fmt, src, 0))
+        return 0;  /* converting nothing checks the formats up front. */
+
+    job.storage = storage;
+    job.dst = (ALubyte *) dst;
+    job.fmt = fmt;
+    job.src = (const ALubyte *) src;
+    job.samples = samples;
+    job.inSize = ((fmt == AL_FORMAT_MONO8) ||
+                  (fmt == AL_FORMAT_STEREO8)) ? 1 : 2;
+    job.outSize = __alSampleSize(storage);
+
+    __alWorkerPoolFor(pool, (samples + (PARALLEL_SAMPLES - 1)) /
+                            PARALLEL_SAMPLES, importPiece, &job);
+    return 1;
+} /* __alSampleImportParallel */
+
+
+static void decodeInt16(ALfloat *dst, const ALshort *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_SAMPLE_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / INT16_SCALE);
+    for (; (i + 8) <= samples; i += 8)
+    {
+        /* put each sample in the top half of a lane, shift down signed. */
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+        dst[i] = ((ALfloat) src[i]) * (1.0f / INT16_SCALE);
+} /* decodeInt16 */
+
+
+static void decodeFloat16(ALfloat *dst, const ALushort *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_SAMPLE_F16C
+    for (; (i + 4) <= samples; i += 4)
+    {
+        const __m128i h = _mm_loadl_epi64((const __m128i *) (src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+        dst[i] = halfToFloat(src[i]);
+} /* decodeFloat16 */
+
+
+static void decodeInt24(ALfloat *dst, const ALubyte *src, ALsizei samples)
+{
+    ALsizei i = 0;
+
+    #if __AL_SAMPLE_SSSE3
+    /* move each 3-byte sample to the top of a lane, then shift down signed. */
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+                                          -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 scale = _mm_set1_ps(1.0f / INT24_SCALE);
+
+    /* each step uses 12 bytes but loads 16; stay inside the data. */
+    for (; (i + 6) <= samples; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + (i * 3)));
+        const __m128i s = _mm_srai_epi32(_mm_shuffle_epi8(v, shuffle), 8);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    } /* for */
+    #endif
+
+    for (; i < samples; i++)
+    {
+        const ALubyte *in = src + (i * 3);
+        const ALint v = (ALint) (((ALuint) in[0] << 8) | ((ALuint) in[1] << 16) |
+                                 ((ALuint) in[2] << 24)) >> 8;
+        dst[i] = ((ALfloat) v) * (1.0f / INT24_SCALE);
+    } /* for */
+} /* decodeInt24 */
+
+
+void __alSampleDecode(ALenum storage, ALfloat *dst, const ALvoid *src,
+                      ALsizei offset, ALsizei samples)
+{
+    switch (storage)
+    {
+        case AL_STORAGE_FLOAT32_IOAL:
+            memcpy(dst, ((const ALfloat *) src) + offset,
+                   samples * sizeof (ALfloat));
+            break;
+
+        case AL_STORAGE_INT16_IOAL:
+            decodeInt16(dst, ((const ALshort *) src) + offset, samples);
+            break;
+
+        case AL_STORAGE_FLOAT16_IOAL:
+            decodeFloat16(dst, ((const ALushort *) src) + offset, samples);
+            break;
+
+        case AL_STORAGE_INT24_IOAL:
+            decodeInt24(dst, ((const ALubyte *) src) + (offset * 3), samples);
+            break;
+    } /* switch */
+} /* __alSampleDecode */
+
+#define GUARD __AL_SAMPLE_GUARD_FRAMES
+
+ALsizei __alPaddedBytes(ALenum storage, ALsizei channels, ALsizei frames)
+{
+    /* guard, samples, guard, then the seam. */
+    return (frames + (GUARD * 6)) * channels * __alSampleSize(storage);
+} /* __alPaddedBytes */
+
+
+void __alPaddedInit(__alPaddedSamples *padded, ALenum storage,
+                    ALsizei channels, ALsizei frames, ALvoid *block)
+{
+    const ALsizei framesize = channels * __alSampleSize(storage);
+    padded->storage = storage;
+    padded->channels = channels;
+    padded->frames = frames;
+    padded->data = ((ALubyte *) block) + (GUARD * framesize);
+    padded->seam = padded->data + ((frames + GUARD) * framesize);
+} /* __alPaddedInit */
+
+
+void __alPaddedFinish(__alPaddedSamples *padded)
+{
+    const ALsizei framesize = padded->channels *
+                              __alSampleSize(padded->storage);
+    const ALsizei frames = padded->frames;
+    ALsizei i;
+
+    /* zero bytes are silence in every storage format. */
+    memset(padded->data - (GUARD * framesize), '\0', GUARD * framesize);
+    memset(padded->data + (frames * framesize), '\0', GUARD * framesize);
+
+    if (frames == 0)
+    {
+        memset(padded->seam, '\0', GUARD * 4 * framesize);
+        return;
+    } /* if */
+
+    /* seam frame (i) is frame (frames - 2 * GUARD + i), wrapped. */
+    for (i = 0; i < (GUARD * 4); i++)
+    {
+        ALsizei frame = ((frames - (GUARD * 2) + i) % frames);
+        if (frame < 0)
+            frame += frames;  /* loops shorter than the seam. */
+        memcpy(padded->seam + (i * framesize),
+               padded->data + (frame * framesize), framesize);
+    } /* for */
+} /* __alPaddedFinish */
+
+
+const ALubyte *__alPaddedSpan(const __alPaddedSamples *padded,
+                              ALboolean looping, ALsizei frame,
+                              ALsizei *count)
+{
+    const ALsizei framesize = padded->channels *
+                              __alSampleSize(padded->storage);
+    const ALsizei frames = padded->frames;
+    const ALubyte *retval;
+    ALsizei avail;
+
+    if (!looping)  /* the guards are silence, like after the end. */
+    {
+        retval = padded->data + (frame * framesize);
+        avail = frames - frame;
+    } /* if */
+    else if (frame >= (frames - GUARD))  /* coming up on the loop point. */
+    {
+        retval = padded->seam + ((frame - (frames - (GUARD * 2))) * framesize);
+        avail = (frames + GUARD) - frame;
+    } /* else if */
+    else if (frame < GUARD)  /* just looped; history is the end. */
+    {
+        retval = padded->seam + ((frame + (GUARD * 2)) * framesize);
+        avail = GUARD - frame;
+    } /* else if */
+    else
+    {
+        retval = padded->data + (frame * framesize);
+        avail = (frames - GUARD) - frame;
+    } /* else */
+
+    if (*count > avail)
+        *count = avail;
+    return retval;
+} /* __alPaddedSpan */
+
+#undef GUARD
+
+/* end of alSample.c ... */
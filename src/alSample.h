@@ -0,0 +1,138 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALSAMPLE_H_
+#define _INCL_ALSAMPLE_H_
+
+#include "alCore.h"
+#include "alWorker.h"
+
+/*
+ * Internal sample storage formats.
+ *
+ * The mix bus is always float, but buffers don't have to be. Each buffer
+ *  picks how the software mixer keeps its samples (AL_BUFFER_STORAGE_IOAL):
+ *
+ *  - AL_STORAGE_FLOAT32_IOAL: four bytes a sample, and nothing to do at
+ *    mix time. The fastest, and the biggest.
+ *  - AL_STORAGE_INT16_IOAL: two bytes. Exactly what most sounds arrive as,
+ *    so nothing is lost.
+ *  - AL_STORAGE_FLOAT16_IOAL: two bytes, with float's headroom and an
+ *    11-bit mantissa; good for data that was produced in float.
+ *  - AL_STORAGE_INT24_IOAL: three bytes, packed, for 24-bit masters that
+ *    shouldn't be cut down to 16.
+ *
+ * Samples are converted to float as they're read for mixing, a run at a
+ *  time, with SSE2 for 16-bit, SSSE3 for 24-bit, and F16C for half floats
+ *  when the compiler allows; otherwise with plain C. Conversion in either
+ *  direction treats full scale as +/-1.0f, and clamps on the way in.
+ */
+
+/* Bytes per sample in (storage), or zero if it's not a storage format. */
+ALsizei __alSampleSize(ALenum storage);
+
+/*
+ * Convert (samples) samples of AL input format (fmt) at (src) into
+ *  (storage) at (dst), for uploadBuffer(). (samples) counts every channel,
+ *  not frames. Returns zero if (fmt) or (storage) is unknown.
+ */
+int __alSampleImport(ALenum storage, ALvoid *dst, ALenum fmt,
+                     const ALvoid *src, ALsizei samples);
+
+/*
+ * __alSampleImport(), split across (pool) for big uploads. Every sample
+ *  converts on its own, so the pieces are just runs of the input, and the
+ *  result is exactly what __alSampleImport() would give. Uploads too small
+ *  to be worth the handoff stay on this thread. (pool) may be NULL.
+ */
+int __alSampleImportParallel(__alWorkerPool *pool, ALenum storage,
+                             ALvoid *dst, ALenum fmt, const ALvoid *src,
+                             ALsizei samples);
+
+/* Convert (samples) floats at (src) into (storage) at (dst). */
+void __alSampleEncode(ALenum storage, ALvoid *dst, const ALfloat *src,
+                      ALsizei samples);
+
+/*
+ * Mixer side. Convert (samples) samples of (storage), starting (offset)
+ *  samples into (src), to float in (dst).
+ */
+void __alSampleDecode(ALenum storage, ALfloat *dst, const ALvoid *src,
+                      ALsizei offset, ALsizei samples);
+
+
+/*
+ * Padded storage.
+ *
+ * An interpolating resampler reads a few frames either side of the one
+ *  it's producing. Near the ends of a buffer those neighbours don't
+ *  exist, or (for a looping source) they're at the other end, and
+ *  checking for that on every sample costs more than the interpolation.
+ *
+ * So the software mixer keeps what uploadBuffer() converts in padded
+ *  storage: __AL_SAMPLE_GUARD_FRAMES frames of silence before frame zero
+ *  and after the last frame, so a one-shot voice can read past either
+ *  end and get what it should. Looping voices get a seam: a little copy
+ *  of the last frames followed by the first ones, 4 * GUARD frames in
+ *  all, so the read window can run straight across the loop point.
+ *
+ * __alPaddedSpan() tells the mixer where to read a run of frames from
+ *  and how long the run can be before it has to ask again; the inner
+ *  loop over that run never checks a bound. It's one decision per run,
+ *  not per sample.
+ *
+ * Static buffers and views reference data that isn't ours to pad, so
+ *  they keep the bounds-checked path.
+ */
+
+/* Frames of guard either side; enough for an eight-tap interpolator. */
+#define __AL_SAMPLE_GUARD_FRAMES 4
+
+typedef struct S_ALPADDEDSAMPLES
+{
+    ALenum storage;
+    ALsizei channels;
+    ALsizei frames;
+    ALubyte *data;           /* frame zero; guards either side. */
+    ALubyte *seam;           /* the loop seam; see above. */
+} __alPaddedSamples;
+
+/* Bytes to allocate for (frames) frames of padded (storage) samples. */
+ALsizei __alPaddedBytes(ALenum storage, ALsizei channels, ALsizei frames);
+
+/*
+ * Lay out (padded) over (block), which is __alPaddedBytes() long. Fill
+ *  (padded->data) with the samples, then call __alPaddedFinish().
+ */
+void __alPaddedInit(__alPaddedSamples *padded, ALenum storage,
+                    ALsizei channels, ALsizei frames, ALvoid *block);
+
+/*
+ * Write the guards and the loop seam. Call it again if frames near either
+ *  end change, as updateBuffer() might; it only touches a few frames.
+ */
+void __alPaddedFinish(__alPaddedSamples *padded);
+
+/*
+ * Where to read from, for a voice at (frame), which must be less than
+ *  (padded->frames). Returns a pointer to that frame, and cuts (*count)
+ *  down to how many frames may be read from there, each with
+ *  __AL_SAMPLE_GUARD_FRAMES of neighbours on either side.
+ *
+ * A one-shot voice reads the storage itself, and its run stops at the
+ *  last frame. A looping voice reads the seam near the loop point, and
+ *  its run may go past the last frame: frame (padded->frames + n) there
+ *  is frame n. Either way, (*count) is never cut to zero.
+ */
+const ALubyte *__alPaddedSpan(const __alPaddedSamples *padded,
+                              ALboolean looping, ALsizei frame,
+                              ALsizei *count);
+
+#endif
+
+/* end of alSample.h ... */
@@ -0,0 +1,508 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define __AL_STREAM_IO_URING 1
+#endif
+#endif
+
+#include "al.h"
+#include "alStream.h"
+
+/* !!! FIXME: This is POSIX only; Windows wants overlapped ReadFile(). */
+
+#if __AL_STREAM_IO_URING
+
+/*
+ * Just enough io_uring to read into our chunks, talking to the kernel
+ *  directly so we don't need liburing.
+ */
+typedef struct
+{
+    int fd;
+    ALuint *sqHead;
+    ALuint *sqTail;
+    ALuint *sqMask;
+    ALuint *sqArray;
+    struct io_uring_sqe *sqes;
+    ALuint *cqHead;
+    ALuint *cqTail;
+    ALuint *cqMask;
+    struct io_uring_cqe *cqes;
+    void *sqMap;
+    size_t sqMapSize;
+    void *cqMap;
+    size_t cqMapSize;
+    size_t sqesSize;
+    ALuint inFlight;
+} Uring;
+
+static void uringDestroy(Uring *ring)
+{
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqesSize);
+    if ((ring->cqMap != NULL) && (ring->cqMap != ring->sqMap))
+        munmap(ring->cqMap, ring->cqMapSize);
+    if (ring->sqMap != NULL)
+        munmap(ring->sqMap, ring->sqMapSize);
+    if (ring->fd != -1)
+        close(ring->fd);
+    free(ring);
+} /* uringDestroy */
+
+
+static Uring *uringCreate(ALuint entries)
+{
+    struct io_uring_params params;
+    ALubyte *sq;
+    ALubyte *cq;
+    Uring *ring;
+    void *ptr;
+
+    ring = (Uring *) calloc(1, sizeof (Uring));
+    if (ring == NULL)
+        return NULL;
+
+    memset(&params, '\0', sizeof (params));
+    ring->fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd == -1)
+    {
+        free(ring);
+        return NULL;  /* no io_uring here; caller falls back to pread. */
+    } /* if */
+
+    ring->sqMapSize = params.sq_off.array + (params.sq_entries * sizeof (ALuint));
+    ring->cqMapSize = params.cq_off.cqes +
+                      (params.cq_entries * sizeof (struct io_uring_cqe));
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cqMapSize > ring->sqMapSize)
+            ring->sqMapSize = ring->cqMapSize;
+        ring->cqMapSize = ring->sqMapSize;
+    } /* if */
+
+    ptr = mmap(NULL, ring->sqMapSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED)
+    {
+        uringDestroy(ring);
+        return NULL;
+    } /* if */
+    ring->sqMap = ptr;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqMap = ring->sqMap;
+    else
+    {
+        ptr = mmap(NULL, ring->cqMapSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ptr == MAP_FAILED)
+        {
+            uringDestroy(ring);
+            return NULL;
+        } /* if */
+        ring->cqMap = ptr;
+    } /* else */
+
+    ring->sqesSize = params.sq_entries * sizeof (struct io_uring_sqe);
+    ptr = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED)
+    {
+        uringDestroy(ring);
+        return NULL;
+    } /* if */
+    ring->sqes = (struct io_uring_sqe *) ptr;
+
+    sq = (ALubyte *) ring->sqMap;
+    cq = (ALubyte *) ring->cqMap;
+    ring->sqHead = (ALuint *) (sq + params.sq_off.head);
+    ring->sqTail = (ALuint *) (sq + params.sq_off.tail);
+    ring->sqMask = (ALuint *) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (ALuint *) (sq + params.sq_off.array);
+    ring->cqHead = (ALuint *) (cq + params.cq_off.head);
+    ring->cqTail = (ALuint *) (cq + params.cq_off.tail);
+    ring->cqMask = (ALuint *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    return ring;
+} /* uringCreate */
+
+
+static int uringRead(Uring *ring, int fd, void *buf, ALsizei len,
+                     unsigned long long offset, ALuint tag)
+{
+    const ALuint tail = *ring->sqTail;
+    const ALuint index = tail & *ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, '\0', sizeof (*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long) (size_t) buf;
+    sqe->len = (ALuint) len;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    ring->sqArray[index] = index;
+    __alAtomicStore(ring->sqTail, tail + 1);
+
+    if (syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) != 1)
+    {
+        /*
+         * EINTR, EAGAIN, EBUSY... If the kernel didn't take the entry,
+         *  take it back out, or the next submit would send it too, into
+         *  a chunk the caller is about to pread() and maybe publish.
+         *  The kernel only looks at the queue inside io_uring_enter(),
+         *  so nobody else can be reading it right now.
+         */
+        if (__alAtomicLoad(ring->sqHead) == tail)
+        {
+            __alAtomicStore(ring->sqTail, tail);
+            return 0;
+        } /* if */
+        /* it took it after all; it'll complete like any other. */
+    } /* if */
+
+    ring->inFlight++;
+    return 1;
+} /* uringRead */
+
+
+/*
+ * Wait for at least one completion, then hand each one to (fn). Returns
+ *  zero if the wait failed for some reason other than a signal.
+ */
+static int uringReap(Uring *ring, void (*fn)(void *, ALuint, int), void *data)
+{
+    ALuint head;
+
+    if (syscall(__NR_io_uring_enter, ring->fd, 0, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0) == -1)
+    {
+        if (errno != EINTR)
+            return 0;
+    } /* if */
+
+    head = *ring->cqHead;
+    while (head != __alAtomicLoad(ring->cqTail))
+    {
+        const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+        fn(data, (ALuint) cqe->user_data, cqe->res);
+        ring->inFlight--;
+        head++;
+    } /* while */
+    __alAtomicStore(ring->cqHead, head);
+
+    return 1;
+} /* uringReap */
+
+#endif  /* __AL_STREAM_IO_URING */
+
+
+static void readChunkNow(__alStream *stream, ALuint index,
+                         unsigned long long offset, ALsizei len)
+{
+    __alStreamChunk *chunk = &stream->chunks[index];
+    ALubyte *dst = stream->window + (index * stream->chunkSize);
+    ALsizei total = 0;
+
+    while (total < len)
+    {
+        const ssize_t rc = pread(stream->fd, dst + total,
+                                 (size_t) (len - total),
+                                 (off_t) (offset + total));
+        if ((rc == -1) && (errno == EINTR))
+            continue;
+        else if (rc <= 0)
+            break;  /* error or truncated file; play what we got. */
+        total += (ALsizei) rc;
+    } /* while */
+
+    chunk->length = total - (total % stream->frameSize);
+    chunk->inFlight = AL_FALSE;
+} /* readChunkNow */
+
+
+#if __AL_STREAM_IO_URING
+static void chunkCompleted(void *data, ALuint index, int res)
+{
+    __alStream *stream = (__alStream *) data;
+    __alStreamChunk *chunk = &stream->chunks[index];
+
+    if ((res >= 0) && (res == chunk->length))
+    {
+        chunk->inFlight = AL_FALSE;
+        return;
+    } /* if */
+
+    /*
+     * Error or short read (io_uring doesn't retry those for us). Redo
+     *  the whole chunk the boring way; if the kernel is rejecting our
+     *  reads outright, stop using io_uring at all.
+     */
+    if ((res == -EINVAL) || (res == -EOPNOTSUPP))
+        stream->uringFailed = AL_TRUE;
+
+    readChunkNow(stream, index, chunk->offset, chunk->length);
+} /* chunkCompleted */
+#endif
+
+
+static int readerThread(void *data)
+{
+    __alStream *stream = (__alStream *) data;
+    const ALuint count = (ALuint) stream->chunkCount;
+    ALboolean eof = AL_FALSE;
+    #if __AL_STREAM_IO_URING
+    Uring *uring = (Uring *) stream->uring;
+    #endif
+
+    while (!stream->quit)
+    {
+        ALuint produced = stream->produced;
+        ALboolean busy = AL_FALSE;
+
+        /* start reading into every free chunk. */
+        while ((!eof) &&
+               ((stream->submitted - __alAtomicLoad(&stream->consumed)) < count))
+        {
+            const ALuint index = stream->submitted % count;
+            const unsigned long long remain = stream->dataEnd - stream->filePos;
+            const ALsizei len = (remain < (unsigned long long) stream->chunkSize) ?
+                                    (ALsizei) remain : stream->chunkSize;
+            __alStreamChunk *chunk = &stream->chunks[index];
+
+            chunk->length = len;
+            chunk->inFlight = AL_TRUE;
+            chunk->offset = stream->filePos;
+
+            #if __AL_STREAM_IO_URING
+            if ( (uring == NULL) || (stream->uringFailed) ||
+                 (!uringRead(uring, stream->fd,
+                             stream->window + (index * stream->chunkSize),
+                             len, stream->filePos, index)) )
+            #endif
+            {
+                readChunkNow(stream, index, stream->filePos, len);
+            }
+
+            stream->submitted++;
+            stream->filePos += (unsigned long long) len;
+            if (stream->filePos >= stream->dataEnd)
+            {
+                if (stream->looping)
+                    stream->filePos = stream->dataStart;
+                else
+                    eof = AL_TRUE;
+            } /* if */
+            busy = AL_TRUE;
+        } /* while */
+
+        #if __AL_STREAM_IO_URING
+        if ((uring != NULL) && (uring->inFlight > 0))
+        {
+            /* sleeps in the kernel until a read finishes. */
+            if (!uringReap(uring, chunkCompleted, stream))
+                stream->uringFailed = AL_TRUE;
+            busy = AL_TRUE;
+        } /* if */
+        #endif
+
+        /* publish finished chunks, strictly in file order. */
+        while ((produced != stream->submitted) &&
+               (!stream->chunks[produced % count].inFlight))
+            produced++;
+        __alAtomicStore(&stream->produced, produced);
+
+        if ((eof) && (produced == stream->submitted))
+        {
+            __alAtomicStore(&stream->readerDone, AL_TRUE);
+            break;
+        } /* if */
+
+        if (!busy)
+            __alThreadSleep(stream->pollMS);
+    } /* while */
+
+    #if __AL_STREAM_IO_URING
+    /* don't let the kernel write into the window after it's freed. */
+    while ((uring != NULL) && (uring->inFlight > 0))
+    {
+        if (!uringReap(uring, chunkCompleted, stream))
+            break;
+    } /* while */
+    #endif
+
+    return 0;
+} /* readerThread */
+
+
+__alStream *__alStreamOpen(const char *path, ALenum fmt, ALsizei freq,
+                           unsigned long long dataOffset,
+                           unsigned long long dataSize,
+                           ALsizei window, ALsizei chunk, ALboolean loop)
+{
+    const ALsizei framesize = __alFormatFrameSize(fmt);
+    __alStream *stream;
+    struct stat statbuf;
+    ALuint chunkMS;
+
+    if ((framesize == 0) || (freq <= 0))
+        return NULL;
+
+    chunk -= chunk % framesize;
+    if ((chunk <= 0) || (window < chunk * 2))
+        return NULL;
+
+    stream = (__alStream *) calloc(1, sizeof (__alStream));
+    if (stream == NULL)
+        return NULL;
+
+    stream->fd = open(path, O_RDONLY);
+    if ((stream->fd == -1) || (fstat(stream->fd, &statbuf) == -1))
+    {
+        __alStreamClose(stream);
+        return NULL;
+    } /* if */
+
+    if (dataSize == 0)
+        dataSize = (unsigned long long) statbuf.st_size - dataOffset;
+
+    stream->format = fmt;
+    stream->frequency = freq;
+    stream->frameSize = framesize;
+    stream->looping = loop;
+    stream->dataStart = dataOffset;
+    stream->dataEnd = dataOffset + (dataSize - (dataSize % framesize));
+    stream->filePos = dataOffset;
+    stream->chunkSize = chunk;
+    stream->chunkCount = window / chunk;
+
+    if ( (dataOffset > (unsigned long long) statbuf.st_size) ||
+         (stream->dataEnd > (unsigned long long) statbuf.st_size) ||
+         (stream->dataEnd == stream->dataStart) )
+    {
+        __alStreamClose(stream);
+        return NULL;
+    } /* if */
+
+    stream->window = (ALubyte *) malloc(stream->chunkCount * chunk);
+    stream->chunks = (__alStreamChunk *) calloc(stream->chunkCount,
+                                                sizeof (__alStreamChunk));
+    if ((stream->window == NULL) || (stream->chunks == NULL))
+    {
+        __alStreamClose(stream);
+        return NULL;
+    } /* if */
+
+    /* look for free chunks a few times per chunk played. */
+    chunkMS = (ALuint) ((((unsigned long long) chunk) * 1000) /
+                        (((unsigned long long) framesize) * freq));
+    stream->pollMS = (chunkMS >= 4) ? (chunkMS / 4) : 1;
+
+    #if __AL_STREAM_IO_URING
+    stream->uring = uringCreate((ALuint) stream->chunkCount);
+    #endif
+
+    stream->thread = __alThreadCreate(readerThread, stream);
+    if (stream->thread == NULL)
+    {
+        __alStreamClose(stream);
+        return NULL;
+    } /* if */
+
+    return stream;
+} /* __alStreamOpen */
+
+
+void __alStreamClose(__alStream *stream)
+{
+    if (stream == NULL)
+        return;
+
+    if (stream->thread != NULL)
+    {
+        stream->quit = 1;
+        __alThreadWait(stream->thread);
+    } /* if */
+
+    #if __AL_STREAM_IO_URING
+    if (stream->uring != NULL)
+        uringDestroy((Uring *) stream->uring);
+    #endif
+
+    if (stream->fd != -1)
+        close(stream->fd);
+    free(stream->window);
+    free(stream->chunks);
+    free(stream);
+} /* __alStreamClose */
+
+
+ALsizei __alStreamPeek(__alStream *stream, const ALubyte **data)
+{
+    const ALuint produced = __alAtomicLoad(&stream->produced);
+    const ALuint count = (ALuint) stream->chunkCount;
+    ALuint consumed = stream->consumed;  /* only we write this. */
+
+    while (consumed != produced)
+    {
+        const ALuint index = consumed % count;
+        const ALsizei avail = stream->chunks[index].length -
+                              stream->consumeOffset;
+        if (avail > 0)
+        {
+            *data = stream->window + (index * stream->chunkSize) +
+                    stream->consumeOffset;
+            return avail;
+        } /* if */
+
+        /* empty chunk (short file); skip it. */
+        stream->consumeOffset = 0;
+        consumed++;
+        __alAtomicStore(&stream->consumed, consumed);
+    } /* while */
+
+    if (!__alAtomicLoad(&stream->readerDone))
+        __alAtomicAdd(&stream->underruns, 1);
+
+    *data = NULL;
+    return 0;
+} /* __alStreamPeek */
+
+
+void __alStreamConsume(__alStream *stream, ALsizei bytes)
+{
+    const ALuint index = stream->consumed % (ALuint) stream->chunkCount;
+
+    stream->consumeOffset += bytes;
+    if (stream->consumeOffset >= stream->chunks[index].length)
+    {
+        stream->consumeOffset = 0;
+        __alAtomicStore(&stream->consumed, stream->consumed + 1);
+    } /* if */
+} /* __alStreamConsume */
+
+
+int __alStreamEnded(__alStream *stream)
+{
+    return ( (__alAtomicLoad(&stream->readerDone)) &&
+             (stream->consumed == __alAtomicLoad(&stream->produced)) );
+} /* __alStreamEnded */
+
+/* end of alStream.c ... */
@@ -0,0 +1,114 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALSTREAM_H_
+#define _INCL_ALSTREAM_H_
+
+#include "alCore.h"
+#include "alThread.h"
+
+/*
+ * File-backed streaming buffers.
+ *
+ * For long music and dialogue, the application shouldn't have to pump
+ *  alSourceQueueBuffers() at all. A stream buffer names a file instead of
+ *  holding samples, and the AL runs a read-ahead thread that keeps a
+ *  window of the file in memory ahead of the source's playback cursor.
+ *
+ * The window is a ring of fixed-size chunks. The read-ahead thread fills
+ *  free chunks in file order and publishes them in that order; the mixer
+ *  consumes them in place with __alStreamPeek() and __alStreamConsume(),
+ *  which never block or take a lock. A consumed chunk is free to be read
+ *  into again the next time the reader looks, which it does a few times
+ *  per chunk's worth of playback. If the mixer catches up with the
+ *  reader, that's an underrun: it gets nothing for now and plays silence,
+ *  and the underrun is counted.
+ *
+ * On Linux, reads go through io_uring, so several chunks can be in flight
+ *  at once and the thread sleeps in the kernel until one completes. If
+ *  io_uring isn't available (old kernel, seccomp, etc) or fails, we fall
+ *  back to plain pread() on the same thread.
+ *
+ * !!! FIXME: The data must already be raw PCM in the buffer's format;
+ * !!! FIXME:  there are no decoders in here yet. "dataOffset" lets you
+ * !!! FIXME:  skip a .wav header, at least.
+ *
+ * Like callback buffers, stream buffers can only be attached with
+ *  AL_BUFFER, not queued.
+ */
+
+typedef struct S_ALSTREAMCHUNK
+{
+    unsigned long long offset;  /* where in the file it came from. */
+    ALsizei length;          /* bytes of data; set by the reader. */
+    ALboolean inFlight;
+} __alStreamChunk;
+
+typedef struct S_ALSTREAM
+{
+    int fd;
+    ALenum format;
+    ALsizei frequency;
+    ALsizei frameSize;
+    ALboolean looping;
+    unsigned long long dataStart;  /* file offset of the first sample. */
+    unsigned long long dataEnd;    /* file offset after the last one. */
+    unsigned long long filePos;    /* next file offset to read; reader's. */
+
+    ALubyte *window;         /* (chunkCount * chunkSize) bytes. */
+    ALsizei chunkSize;
+    ALsizei chunkCount;
+    __alStreamChunk *chunks;
+
+    /* chunk counters; they only go up, and are used modulo chunkCount. */
+    ALuint submitted;        /* reads started; reader only. */
+    ALuint produced;         /* reads finished, in order; atomic. */
+    ALuint consumed;         /* chunks the mixer is done with; atomic. */
+    ALsizei consumeOffset;   /* bytes into the current chunk; mixer only. */
+
+    ALboolean readerDone;    /* everything has been produced; atomic. */
+    ALuint underruns;        /* times the mixer found nothing; atomic. */
+
+    void *uring;             /* NULL if we're using pread(). */
+    ALboolean uringFailed;   /* stopped trusting it; pread() from now on. */
+    ALuint pollMS;           /* reader's nap when it has nothing to do. */
+    volatile int quit;
+    __alThread *thread;
+} __alStream;
+
+/*
+ * Open (path) for streaming, starting the read-ahead thread. The sample
+ *  data is (dataSize) bytes at (dataOffset), in (fmt) at (freq); a
+ *  (dataSize) of zero means "to the end of the file". The read-ahead
+ *  window is (window) bytes, read (chunk) bytes at a time; both are
+ *  rounded to whole sample frames. Returns NULL on failure.
+ */
+__alStream *__alStreamOpen(const char *path, ALenum fmt, ALsizei freq,
+                           unsigned long long dataOffset,
+                           unsigned long long dataSize,
+                           ALsizei window, ALsizei chunk, ALboolean loop);
+
+/* Stop the read-ahead thread and close the file. */
+void __alStreamClose(__alStream *stream);
+
+/*
+ * Mixer side. Sets (*data) to the next contiguous run of sample data and
+ *  returns its size in bytes, or zero if nothing is ready yet (see
+ *  __alStreamEnded() to tell an underrun from the end of the stream).
+ */
+ALsizei __alStreamPeek(__alStream *stream, const ALubyte **data);
+
+/* Mixer side. Mark (bytes) of the last peeked data as played. */
+void __alStreamConsume(__alStream *stream, ALsizei bytes);
+
+/* Non-zero if everything has been read and played. */
+int __alStreamEnded(__alStream *stream);
+
+#endif
+
+/* end of alStream.h ... */
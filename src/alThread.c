@@ -0,0 +1,247 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "al.h"
+#include "alThread.h"
+
+/* !!! FIXME: This is pthreads only; Windows needs its own version. */
+
+struct S_ALTHREAD
+{
+    pthread_t thread;
+    int (*fn)(void *data);
+    void *data;
+    int retval;
+};
+
+struct S_ALMUTEX
+{
+    pthread_mutex_t mutex;
+};
+
+struct S_ALSEMAPHORE
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ALuint count;
+};
+
+
+static void *threadEntry(void *arg)
+{
+    __alThread *thread = (__alThread *) arg;
+    thread->retval = thread->fn(thread->data);
+    return NULL;
+} /* threadEntry */
+
+
+__alThread *__alThreadCreate(int (*fn)(void *data), void *data)
+{
+    __alThread *thread = (__alThread *) malloc(sizeof (__alThread));
+    if (thread == NULL)
+        return NULL;
+
+    thread->fn = fn;
+    thread->data = data;
+    thread->retval = 0;
+    if (pthread_create(&thread->thread, NULL, threadEntry, thread) != 0)
+    {
+        free(thread);
+        return NULL;
+    } /* if */
+
+    return thread;
+} /* __alThreadCreate */
+
+
+int __alThreadWait(__alThread *thread)
+{
+    int retval;
+    pthread_join(thread->thread, NULL);
+    retval = thread->retval;
+    free(thread);
+    return retval;
+} /* __alThreadWait */
+
+
+void __alThreadSleep(ALuint ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long) (ms % 1000) * 1000000L;
+    while ((nanosleep(&ts, &ts) == -1) && (errno == EINTR))
+        /* keep sleeping */ ;
+} /* __alThreadSleep */
+
+
+void __alThreadYield(void)
+{
+    sched_yield();
+} /* __alThreadYield */
+
+
+ALuint __alCpuCount(void)
+{
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (ALuint) count : 1;
+} /* __alCpuCount */
+
+
+unsigned long long __alTicksNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((unsigned long long) ts.tv_sec) * 1000000000ULL) +
+           ((unsigned long long) ts.tv_nsec);
+} /* __alTicksNS */
+
+
+__alMutex *__alMutexCreate(void)
+{
+    __alMutex *mutex = (__alMutex *) malloc(sizeof (__alMutex));
+    if (mutex == NULL)
+        return NULL;
+
+    if (pthread_mutex_init(&mutex->mutex, NULL) != 0)
+    {
+        free(mutex);
+        return NULL;
+    } /* if */
+
+    return mutex;
+} /* __alMutexCreate */
+
+
+void __alMutexDestroy(__alMutex *mutex)
+{
+    if (mutex != NULL)
+    {
+        pthread_mutex_destroy(&mutex->mutex);
+        free(mutex);
+    } /* if */
+} /* __alMutexDestroy */
+
+
+void __alMutexLock(__alMutex *mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+} /* __alMutexLock */
+
+
+void __alMutexUnlock(__alMutex *mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+} /* __alMutexUnlock */
+
+
+__alSemaphore *__alSemaphoreCreate(ALuint initial)
+{
+    __alSemaphore *sem = (__alSemaphore *) malloc(sizeof (__alSemaphore));
+    if (sem == NULL)
+        return NULL;
+
+    if (pthread_mutex_init(&sem->mutex, NULL) != 0)
+    {
+        free(sem);
+        return NULL;
+    } /* if */
+
+    if (pthread_cond_init(&sem->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&sem->mutex);
+        free(sem);
+        return NULL;
+    } /* if */
+
+    sem->count = initial;
+    return sem;
+} /* __alSemaphoreCreate */
+
+
+void __alSemaphoreDestroy(__alSemaphore *sem)
+{
+    if (sem != NULL)
+    {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->mutex);
+        free(sem);
+    } /* if */
+} /* __alSemaphoreDestroy */
+
+
+void __alSemaphorePost(__alSemaphore *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+} /* __alSemaphorePost */
+
+
+void __alSemaphoreWait(__alSemaphore *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0)
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+} /* __alSemaphoreWait */
+
+
+int __alSemaphoreTryWait(__alSemaphore *sem)
+{
+    int retval = 0;
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count > 0)
+    {
+        sem->count--;
+        retval = 1;
+    } /* if */
+    pthread_mutex_unlock(&sem->mutex);
+    return retval;
+} /* __alSemaphoreTryWait */
+
+
+int __alSemaphoreWaitTimeout(__alSemaphore *sem, ALuint ms)
+{
+    struct timespec deadline;
+    int retval = 1;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long) (ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    } /* if */
+
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0)
+    {
+        if (pthread_cond_timedwait(&sem->cond, &sem->mutex, &deadline) == ETIMEDOUT)
+        {
+            retval = (sem->count > 0);
+            break;
+        } /* if */
+    } /* while */
+
+    if (retval)
+        sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+    return retval;
+} /* __alSemaphoreWaitTimeout */
+
+/* end of alThread.c ... */
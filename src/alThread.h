@@ -0,0 +1,87 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALTHREAD_H_
+#define _INCL_ALTHREAD_H_
+
+/*
+ * Threading primitives used inside the AL. These are thin, opaque
+ *  wrappers so the rest of the library doesn't care what the platform
+ *  gives us. alThread.c implements them on top of pthreads.
+ *
+ * Nothing here is meant for the mixer's inner loops except the atomics;
+ *  the mixer should never block on a mutex that the application's thread
+ *  can hold for a long time.
+ */
+
+typedef struct S_ALTHREAD __alThread;
+typedef struct S_ALMUTEX __alMutex;
+typedef struct S_ALSEMAPHORE __alSemaphore;
+
+/*
+ * Start a thread running (fn), passing it (data). Returns NULL on
+ *  failure. Every thread must be waited on with __alThreadWait().
+ */
+__alThread *__alThreadCreate(int (*fn)(void *data), void *data);
+
+/* Block until (thread) terminates, free it, and return its exit value. */
+int __alThreadWait(__alThread *thread);
+
+/* Sleep the calling thread for (ms) milliseconds. */
+void __alThreadSleep(ALuint ms);
+
+/* Let another thread have the CPU, if one wants it. */
+void __alThreadYield(void);
+
+/* How many CPU cores are online; at least one. */
+ALuint __alCpuCount(void);
+
+/* A monotonic clock, in nanoseconds from some arbitrary start. */
+unsigned long long __alTicksNS(void);
+
+/* Non-recursive mutex. Create returns NULL on failure. */
+__alMutex *__alMutexCreate(void);
+void __alMutexDestroy(__alMutex *mutex);
+void __alMutexLock(__alMutex *mutex);
+void __alMutexUnlock(__alMutex *mutex);
+
+/* Counting semaphore. Create returns NULL on failure. */
+__alSemaphore *__alSemaphoreCreate(ALuint initial);
+void __alSemaphoreDestroy(__alSemaphore *sem);
+void __alSemaphorePost(__alSemaphore *sem);
+void __alSemaphoreWait(__alSemaphore *sem);
+
+/* Returns non-zero if the count was taken, zero if it would block. */
+int __alSemaphoreTryWait(__alSemaphore *sem);
+
+/*
+ * Wait at most (ms) milliseconds. Returns non-zero if the count was
+ *  taken, zero on timeout.
+ */
+int __alSemaphoreWaitTimeout(__alSemaphore *sem, ALuint ms);
+
+/*
+ * Atomics. Loads acquire, stores release, read-modify-write ops do both.
+ *  These work on any naturally aligned integer or pointer lvalue.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define __alAtomicLoad(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define __alAtomicStore(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define __alAtomicAdd(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+#define __alAtomicSub(ptr, val) __atomic_fetch_sub((ptr), (val), __ATOMIC_ACQ_REL)
+#define __alAtomicExchange(ptr, val) __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#define __alAtomicCAS(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 0, \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#error !!! FIXME: write atomics for this compiler.
+#endif
+
+#endif
+
+/* end of alThread.h ... */
@@ -0,0 +1,310 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alWorker.h"
+
+static int workerThread(void *data)
+{
+    __alWorkerPool *pool = (__alWorkerPool *) data;
+
+    /*
+     * Every wakeup is either a job or a thread's turn to quit. Deinit
+     *  doesn't post the quits until every job has finished, so a wakeup
+     *  with (quit) set is always the latter.
+     */
+    while (1)
+    {
+        __alJob *job;
+
+        __alSemaphoreWait(pool->wake);
+
+        /*
+         * A post means some push has finished, but maybe not the one at
+         *  the head of the queue: another producer may have claimed that
+         *  slot and not filled it yet, and until it does, pops come back
+         *  empty. That job is on its way, so wait for it. Going back to
+         *  sleep would waste this post, and nobody posts twice.
+         */
+        while ((job = (__alJob *) __alQueuePop(&pool->jobs)) == NULL)
+        {
+            if (__alAtomicLoad(&pool->quit))
+                break;
+            __alThreadYield();
+        } /* while */
+
+        if (job == NULL)
+            break;
+
+        job->run(job);
+        __alAtomicSub(&pool->pending, 1);
+    } /* while */
+
+    return 0;
+} /* workerThread */
+
+
+int __alWorkerPoolInit(__alWorkerPool *pool, ALuint threads, ALuint capacity)
+{
+    ALuint i;
+
+    if (threads == 0)
+    {
+        threads = __alCpuCount();
+        threads = (threads > 1) ? (threads - 1) : 1;
+    } /* if */
+
+    memset(pool, '\0', sizeof (__alWorkerPool));
+    if (!__alQueueInit(&pool->jobs, capacity))
+        return 0;
+
+    pool->wake = __alSemaphoreCreate(0);
+    pool->threads = (__alThread **) calloc(threads, sizeof (__alThread *));
+    if ((pool->wake == NULL) || (pool->threads == NULL))
+    {
+        __alWorkerPoolDeinit(pool);
+        return 0;
+    } /* if */
+
+    /* settle for fewer threads if we have to, but not for none. */
+    for (i = 0; i < threads; i++)
+    {
+        pool->threads[i] = __alThreadCreate(workerThread, pool);
+        if (pool->threads[i] == NULL)
+            break;
+        pool->threadCount++;
+    } /* for */
+
+    if (pool->threadCount == 0)
+    {
+        __alWorkerPoolDeinit(pool);
+        return 0;
+    } /* if */
+
+    return 1;
+} /* __alWorkerPoolInit */
+
+
+void __alWorkerPoolDeinit(__alWorkerPool *pool)
+{
+    ALuint i;
+
+    /*
+     * Let everything already submitted finish first, including anything
+     *  those jobs submit themselves (__alWorkerPoolFor() helpers, say).
+     */
+    while (__alAtomicLoad(&pool->pending) != 0)
+        __alThreadSleep(1);
+
+    __alAtomicStore(&pool->quit, 1);
+    for (i = 0; i < pool->threadCount; i++)
+        __alSemaphorePost(pool->wake);
+    for (i = 0; i < pool->threadCount; i++)
+        __alThreadWait(pool->threads[i]);
+
+    free(pool->threads);
+    if (pool->wake != NULL)
+        __alSemaphoreDestroy(pool->wake);
+    if (pool->jobs.cells != NULL)
+        __alQueueDeinit(&pool->jobs);
+    memset(pool, '\0', sizeof (__alWorkerPool));
+} /* __alWorkerPoolDeinit */
+
+
+void __alWorkerPoolSubmit(__alWorkerPool *pool, __alJob *job)
+{
+    __alAtomicAdd(&pool->pending, 1);
+    if (__alQueuePush(&pool->jobs, job))
+        __alSemaphorePost(pool->wake);
+    else  /* backed up; do it ourselves. */
+    {
+        __alAtomicSub(&pool->pending, 1);
+        job->run(job);
+    } /* else */
+} /* __alWorkerPoolSubmit */
+
+
+/* shared by the caller and helpers of one __alWorkerPoolFor(). */
+typedef struct S_ALPARALLELFOR
+{
+    void (*fn)(void *data, ALsizei index);
+    void *data;
+    ALsizei count;
+    ALsizei next;             /* next index to hand out; atomic. */
+    ALsizei finished;         /* atomic. */
+    ALuint refcount;          /* the caller, plus each helper; atomic. */
+    __alSemaphore *done;      /* posted when the last index finishes. */
+} __alParallelFor;
+
+typedef struct S_ALPARALLELHELPER
+{
+    __alJob job;
+    __alParallelFor *parallel;
+} __alParallelHelper;
+
+
+static void parallelWork(__alParallelFor *parallel)
+{
+    while (1)
+    {
+        const ALsizei index = __alAtomicAdd(&parallel->next, 1);
+        if (index >= parallel->count)
+            break;
+
+        parallel->fn(parallel->data, index);
+        if (__alAtomicAdd(&parallel->finished, 1) == (parallel->count - 1))
+            __alSemaphorePost(parallel->done);
+    } /* while */
+} /* parallelWork */
+
+
+/*
+ * A helper may not get to run until after the caller has returned, so
+ *  the state lives on the heap and the last one out frees it.
+ */
+static void parallelRelease(__alParallelFor *parallel)
+{
+    if (__alAtomicSub(&parallel->refcount, 1) == 1)
+    {
+        __alSemaphoreDestroy(parallel->done);
+        free(parallel);
+    } /* if */
+} /* parallelRelease */
+
+
+static void runParallelHelper(__alJob *job)
+{
+    __alParallelFor *parallel = ((__alParallelHelper *) job)->parallel;
+    parallelWork(parallel);
+    parallelRelease(parallel);
+} /* runParallelHelper */
+
+
+void __alWorkerPoolFor(__alWorkerPool *pool, ALsizei count,
+                       void (*fn)(void *data, ALsizei index), void *data)
+{
+    __alParallelFor *parallel = NULL;
+    __alParallelHelper *helpers;
+    ALsizei helperCount = 0;
+    ALsizei i;
+
+    if ((pool != NULL) && (count > 1))
+    {
+        helperCount = (ALsizei) pool->threadCount;
+        if (helperCount > (count - 1))
+            helperCount = count - 1;
+        parallel = (__alParallelFor *) malloc(sizeof (__alParallelFor) +
+                                (sizeof (__alParallelHelper) * helperCount));
+    } /* if */
+
+    if (parallel != NULL)
+    {
+        parallel->done = __alSemaphoreCreate(0);
+        if (parallel->done == NULL)
+        {
+            free(parallel);
+            parallel = NULL;
+        } /* if */
+    } /* if */
+
+    if (parallel == NULL)  /* nothing to share, or no memory to share it. */
+    {
+        for (i = 0; i < count; i++)
+            fn(data, i);
+        return;
+    } /* if */
+
+    parallel->fn = fn;
+    parallel->data = data;
+    parallel->count = count;
+    parallel->next = 0;
+    parallel->finished = 0;
+    parallel->refcount = (ALuint) helperCount + 1;
+
+    helpers = (__alParallelHelper *) (parallel + 1);
+    for (i = 0; i < helperCount; i++)
+    {
+        helpers[i].job.run = runParallelHelper;
+        helpers[i].parallel = parallel;
+        __alWorkerPoolSubmit(pool, &helpers[i].job);
+    } /* for */
+
+    parallelWork(parallel);
+    __alSemaphoreWait(parallel->done);  /* posted exactly once. */
+    parallelRelease(parallel);
+} /* __alWorkerPoolFor */
+
+
+int __alFenceInit(__alFence *fence)
+{
+    fence->pending = 0;
+    fence->result = AL_NO_ERROR;
+    fence->done = __alSemaphoreCreate(0);
+    return (fence->done != NULL);
+} /* __alFenceInit */
+
+
+void __alFenceDeinit(__alFence *fence)
+{
+    if (fence->done != NULL)
+        __alSemaphoreDestroy(fence->done);
+    fence->done = NULL;
+} /* __alFenceDeinit */
+
+
+void __alFenceArm(__alFence *fence, ALuint count)
+{
+    /*
+     * Nothing can signal between these two: the jobs that will signal
+     *  haven't been submitted yet, and the old ones are all done.
+     */
+    if (__alAtomicAdd(&fence->pending, count) == 0)
+        __alAtomicStore(&fence->result, AL_NO_ERROR);
+} /* __alFenceArm */
+
+
+void __alFenceSignal(__alFence *fence, ALenum result)
+{
+    if (result != AL_NO_ERROR)
+    {
+        ALenum expected = AL_NO_ERROR;
+        __alAtomicCAS(&fence->result, &expected, result);
+    } /* if */
+
+    if (__alAtomicSub(&fence->pending, 1) == 1)
+        __alSemaphorePost(fence->done);
+} /* __alFenceSignal */
+
+
+ALboolean __alFenceQuery(__alFence *fence)
+{
+    return (__alAtomicLoad(&fence->pending) == 0) ? AL_TRUE : AL_FALSE;
+} /* __alFenceQuery */
+
+
+ALenum __alFenceWait(__alFence *fence)
+{
+    if (__alAtomicLoad(&fence->pending) != 0)
+    {
+        /*
+         * The last signal posts once. Whoever wakes on it passes it on,
+         *  so every waiter gets through; a post left over from an earlier
+         *  round just sends us around the loop again.
+         */
+        while (__alAtomicLoad(&fence->pending) != 0)
+            __alSemaphoreWait(fence->done);
+        __alSemaphorePost(fence->done);
+    } /* if */
+
+    return __alAtomicLoad(&fence->result);
+} /* __alFenceWait */
+
+/* end of alWorker.c ... */
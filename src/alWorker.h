@@ -0,0 +1,124 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+#ifndef _INCL_ALWORKER_H_
+#define _INCL_ALWORKER_H_
+
+#include "alCore.h"
+#include "alQueue.h"
+#include "alThread.h"
+
+/*
+ * Worker threads and fences.
+ *
+ * Some work is too slow to do on the application's thread and has nothing
+ *  to do with the mixer: converting a multi-megabyte upload, for example.
+ *  A worker pool is a handful of threads that sleep on a semaphore until
+ *  jobs show up in a lock-free queue (alQueue.h), run them, and go back to
+ *  sleep. The application's thread only pays for a push and a post.
+ *
+ * Jobs are intrusive: embed an __alJob at the start of your own struct,
+ *  point (run) at a function that casts it back, and submit that. The pool
+ *  never allocates anything per job, and never touches a job again once
+ *  (run) has been called, so (run) may free it.
+ *
+ * A fence is how the submitter finds out the work is done. It counts
+ *  outstanding jobs; each job signals it once when it finishes, with an
+ *  AL error code, and the fence remembers the first error it hears about.
+ *  Querying a fence never blocks, so an application can poll it once a
+ *  frame; waiting on it blocks until the count hits zero.
+ *
+ * Nothing here is for the mixer thread. Submitting doesn't block, but it
+ *  does take the semaphore's lock.
+ */
+
+typedef struct S_ALJOB
+{
+    void (*run)(struct S_ALJOB *job);
+} __alJob;
+
+typedef struct S_ALWORKERPOOL
+{
+    __alQueue jobs;
+    __alSemaphore *wake;      /* a post per job, and per thread to quit. */
+    ALuint threadCount;
+    __alThread **threads;
+    ALuint pending;           /* submitted and not finished; atomic. */
+    ALuint quit;              /* atomic. */
+} __alWorkerPool;
+
+/*
+ * Start (threads) workers; zero picks one less than the number of CPU
+ *  cores, so the application's thread keeps one, but at least one.
+ *  (capacity) is how many jobs may wait at once. Returns zero on failure.
+ */
+int __alWorkerPoolInit(__alWorkerPool *pool, ALuint threads, ALuint capacity);
+
+/*
+ * Runs every job already submitted, and any they submit in turn, then
+ *  stops the workers.
+ */
+void __alWorkerPoolDeinit(__alWorkerPool *pool);
+
+/*
+ * Hand (job) to a worker. This never fails: if the queue is full, the job
+ *  runs right here on the calling thread instead, which is slower for the
+ *  caller but still correct.
+ */
+void __alWorkerPoolSubmit(__alWorkerPool *pool, __alJob *job);
+
+/*
+ * Call (fn) once for each (index) from zero to (count - 1), spread across
+ *  the pool, and return when they've all finished. The calling thread
+ *  does its share too, so this is safe to call from a job running on the
+ *  same pool: it never waits for a worker to come free, only for the
+ *  calls already in progress. The calls may run in any order and at the
+ *  same time, so each should touch its own slice of the output.
+ *
+ * (pool) may be NULL, in which case everything runs here, in order.
+ */
+void __alWorkerPoolFor(__alWorkerPool *pool, ALsizei count,
+                       void (*fn)(void *data, ALsizei index), void *data);
+
+
+typedef struct S_ALFENCE
+{
+    ALuint pending;           /* jobs still running; atomic. */
+    ALenum result;            /* first error reported; atomic. */
+    __alSemaphore *done;      /* posted when (pending) reaches zero. */
+} __alFence;
+
+/* A new fence is signaled (nothing pending). Returns zero on failure. */
+int __alFenceInit(__alFence *fence);
+
+/* Nothing may be pending on (fence) by now; wait on it first. */
+void __alFenceDeinit(__alFence *fence);
+
+/*
+ * Add (count) jobs to (fence), before they're submitted. If the fence was
+ *  signaled, its result goes back to AL_NO_ERROR; otherwise the new jobs
+ *  just join the ones already pending. Only one thread may arm a fence.
+ */
+void __alFenceArm(__alFence *fence, ALuint count);
+
+/* A job is done; (result) is its error code, or AL_NO_ERROR. */
+void __alFenceSignal(__alFence *fence, ALenum result);
+
+/* AL_TRUE if nothing is pending on (fence). Never blocks. */
+ALboolean __alFenceQuery(__alFence *fence);
+
+/*
+ * Block until nothing is pending on (fence), and return the first error
+ *  any of its jobs reported, or AL_NO_ERROR. Any number of threads may
+ *  wait on the same fence.
+ */
+ALenum __alFenceWait(__alFence *fence);
+
+#endif
+
+/* end of alWorker.h ... */
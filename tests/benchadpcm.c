@@ -0,0 +1,122 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * ADPCM decode throughput: a loop of __alAdpcmDecodeBlock(), which is
+ *  the scalar decoder for mono and stereo, against
+ *  __alAdpcmDecodeBlocks(), which runs blocks side by side in SIMD lanes
+ *  where it can. Both decode the same few megabytes of noise, over and
+ *  over, and we report sample frames per second.
+ *
+ * Build it like testadpcm.c:
+ *
+ *   cc -O2 -I../src benchadpcm.c ../src/alAdpcm.c ../src/alWorker.c \
+ *      ../src/alQueue.c ../src/alThread.c -lpthread
+ *
+ * Pass a number of passes on the command line for steadier numbers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "al.h"
+#include "alc.h"
+#include "alAdpcm.h"
+#include "alThread.h"
+
+#define BENCH_BLOCKS 16384
+
+static double perSecond(unsigned long long frames, unsigned long long ns)
+{
+    return (ns == 0) ? 0.0 : (((double) frames) * 1000000000.0) / ns;
+} /* perSecond */
+
+
+static void bench(const char *name, ALenum fmt, int passes)
+{
+    const ALsizei blockAlign = __alAdpcmBlockAlign(fmt, 0);
+    const ALsizei size = blockAlign * BENCH_BLOCKS;
+    ALubyte *data = (ALubyte *) malloc(size);
+    ALshort *out = NULL;
+    unsigned long long start, scalar, simd, frames;
+    unsigned int seed = 0x2545F491;
+    __alAdpcm adpcm;
+    ALsizei i;
+    int pass;
+
+    if (data == NULL)
+    {
+        printf("%s: out of memory\n", name);
+        return;
+    } /* if */
+
+    for (i = 0; i < size; i++)
+    {
+        seed = (seed * 1103515245) + 12345;
+        data[i] = (ALubyte) (seed >> 16);
+    } /* for */
+
+    if (__alAdpcmInit(&adpcm, fmt, data, size, blockAlign, AL_FALSE) !=
+        AL_NO_ERROR)
+    {
+        printf("%s: couldn't set up\n", name);
+        free(data);
+        return;
+    } /* if */
+
+    out = (ALshort *) malloc(sizeof (ALshort) * adpcm.blockFrames *
+                             adpcm.channels * BENCH_BLOCKS);
+    if (out == NULL)
+    {
+        printf("%s: out of memory\n", name);
+        __alAdpcmFree(&adpcm);
+        free(data);
+        return;
+    } /* if */
+
+    start = __alTicksNS();
+    for (pass = 0; pass < passes; pass++)
+    {
+        const ALsizei stride = adpcm.blockFrames * adpcm.channels;
+        for (i = 0; i < adpcm.blockCount; i++)
+            __alAdpcmDecodeBlock(&adpcm, i, out + (i * stride));
+    } /* for */
+    scalar = __alTicksNS() - start;
+
+    start = __alTicksNS();
+    for (pass = 0; pass < passes; pass++)
+        __alAdpcmDecodeBlocks(&adpcm, 0, adpcm.blockCount, out);
+    simd = __alTicksNS() - start;
+
+    frames = ((unsigned long long) adpcm.frames) * passes;
+    printf("%-14s one block at a time: %8.1f Mframes/s,"
+           " batched: %8.1f Mframes/s (%.2fx)\n", name,
+           perSecond(frames, scalar) / 1000000.0,
+           perSecond(frames, simd) / 1000000.0,
+           (simd == 0) ? 0.0 : ((double) scalar) / simd);
+
+    __alAdpcmFree(&adpcm);
+    free(out);
+    free(data);
+} /* bench */
+
+
+int main(int argc, char **argv)
+{
+    int passes = (argc > 1) ? atoi(argv[1]) : 20;
+    if (passes <= 0)
+        passes = 20;
+
+    bench("mono IMA", AL_FORMAT_MONO_IMA4, passes);
+    bench("stereo IMA", AL_FORMAT_STEREO_IMA4, passes);
+    bench("mono MS", AL_FORMAT_MONO_MSADPCM_SOFT, passes);
+    bench("stereo MS", AL_FORMAT_STEREO_MSADPCM_SOFT, passes);
+    return 0;
+} /* main */
+
+/* end of benchadpcm.c ... */
@@ -0,0 +1,376 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * HRTF rendering: what a voice costs per quantum, and whether the
+ *  partitioned convolution gets the right answer.
+ *
+ * We write a made-up HRIR set (a grid of directions, decaying noise for
+ *  impulse responses) to a scratch file and load it like the mixer would.
+ *  The check runs a few voices through the renderer and compares the
+ *  output with plain time-domain convolution. The benchmark then times
+ *  steady voices, which share one inverse FFT per quantum, and moving
+ *  ones, which crossfade every quantum, at a few partition sizes and
+ *  impulse response lengths, and reports nanoseconds per voice per
+ *  quantum.
+ *
+ * Build it with the AL headers in the include path, something like:
+ *
+ *   cc -O2 -I../src benchhrtf.c ../src/alHrtf.c ../src/alFFT.c \
+ *      ../src/alThread.c -lpthread -lm
+ *
+ * Pass a number of quanta on the command line for steadier numbers. It
+ *  exits non-zero if the check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "al.h"
+#include "alc.h"
+#include "alHrtf.h"
+#include "alThread.h"
+
+#define SCRATCH_PATH "benchhrtf.hrir"
+#define FREQUENCY 48000
+#define AZIMUTHS 24       /* every 15 degrees. */
+#define ELEVATIONS 5      /* -60 to 60, every 30 degrees. */
+#define MAX_VOICES 64
+
+static int failures = 0;
+
+static unsigned int rngState = 0x9E3779B9;
+static ALfloat rng(void)  /* -1.0 to 1.0 */
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (((ALfloat) (rngState >> 8)) / 8388608.0f) - 1.0f;
+} /* rng */
+
+
+static int writeUint32(FILE *io, ALuint val)
+{
+    ALubyte bytes[4];
+    bytes[0] = (ALubyte) (val & 0xFF);
+    bytes[1] = (ALubyte) ((val >> 8) & 0xFF);
+    bytes[2] = (ALubyte) ((val >> 16) & 0xFF);
+    bytes[3] = (ALubyte) ((val >> 24) & 0xFF);
+    return (fwrite(bytes, sizeof (bytes), 1, io) == 1);
+} /* writeUint32 */
+
+
+static int writeFloat32(FILE *io, ALfloat val)
+{
+    ALuint bits;
+    memcpy(&bits, &val, sizeof (bits));
+    return writeUint32(io, bits);
+} /* writeFloat32 */
+
+
+static ALfloat azimuthOf(ALsizei i)
+{
+    return (ALfloat) ((i % AZIMUTHS) * (360 / AZIMUTHS)) - 180.0f;
+} /* azimuthOf */
+
+
+static ALfloat elevationOf(ALsizei i)
+{
+    return (ALfloat) (((i / AZIMUTHS) * 30) - 60);
+} /* elevationOf */
+
+
+/*
+ * Write a set with (taps)-sample impulse responses, and keep them in
+ *  (*irs), left then right for each measurement, for the check.
+ */
+static int makeSet(ALsizei taps, ALfloat **irs)
+{
+    const ALsizei count = AZIMUTHS * ELEVATIONS;
+    FILE *io = fopen(SCRATCH_PATH, "wb");
+    ALsizei i, t;
+    int ok;
+
+    *irs = (ALfloat *) malloc(sizeof (ALfloat) * count * taps * 2);
+    if ((io == NULL) || (*irs == NULL))
+    {
+        if (io != NULL)
+            fclose(io);
+        free(*irs);
+        *irs = NULL;
+        return 0;
+    } /* if */
+
+    ok = (fwrite("ioALHRIR", 8, 1, io) == 1);
+    ok = ok && writeUint32(io, FREQUENCY);
+    ok = ok && writeUint32(io, (ALuint) taps);
+    ok = ok && writeUint32(io, (ALuint) count);
+
+    for (i = 0; ok && (i < count); i++)
+    {
+        ALfloat *ir = *irs + (i * taps * 2);
+        ok = writeFloat32(io, azimuthOf(i)) &&
+             writeFloat32(io, elevationOf(i));
+        for (t = 0; t < taps * 2; t++)
+        {
+            const ALfloat decay = (ALfloat) exp(-4.0 * (t % taps) / taps);
+            ir[t] = rng() * decay * 0.25f;
+            ok = ok && writeFloat32(io, ir[t]);
+        } /* for */
+    } /* for */
+
+    if (fclose(io) != 0)
+        ok = 0;
+
+    if (!ok)
+    {
+        free(*irs);
+        *irs = NULL;
+    } /* if */
+    return ok;
+} /* makeSet */
+
+
+static void pointAt(__alHrtfVoice *voice, ALsizei measurement)
+{
+    const ALfloat toRadians = (ALfloat) (M_PI / 180.0);
+    __alHrtfVoiceSetDirection(voice, azimuthOf(measurement) * toRadians,
+                              elevationOf(measurement) * toRadians);
+} /* pointAt */
+
+
+/*
+ * Three steady voices, summed by the renderer, against the sum of each
+ *  one's input convolved with its measurement's impulse responses.
+ */
+static void check(const __alHrirSet *set, const ALfloat *irs, ALsizei taps)
+{
+    static const ALsizei measurements[3] = { 0, 29, 107 };
+    const ALsizei block = set->partitionSize;
+    const ALsizei quanta = ((taps / block) + 3);
+    const ALsizei frames = quanta * block;
+    ALfloat *input = (ALfloat *) malloc(sizeof (ALfloat) * 3 * frames);
+    ALfloat *output = (ALfloat *) calloc(frames * 2, sizeof (ALfloat));
+    __alHrtfVoice voices[3];
+    __alHrtfRenderer renderer;
+    double worst = 0.0;
+    double peak = 0.0;
+    ALsizei v, q, i, t;
+
+    if ((input == NULL) || (output == NULL) ||
+        (!__alHrtfRendererInit(&renderer, set)))
+    {
+        printf("FAIL: out of memory\n");
+        failures++;
+        free(input);
+        free(output);
+        return;
+    } /* if */
+
+    for (i = 0; i < 3 * frames; i++)
+        input[i] = rng();
+
+    for (v = 0; v < 3; v++)
+    {
+        if (!__alHrtfVoiceInit(&voices[v], set))
+        {
+            printf("FAIL: out of memory\n");
+            failures++;
+            while (v-- > 0)
+                __alHrtfVoiceDeinit(&voices[v]);
+            __alHrtfRendererDeinit(&renderer);
+            free(input);
+            free(output);
+            return;
+        } /* if */
+        pointAt(&voices[v], measurements[v]);
+        __alHrtfVoiceReset(&voices[v]);  /* start on that filter. */
+    } /* for */
+
+    for (q = 0; q < quanta; q++)
+    {
+        __alHrtfRendererBegin(&renderer);
+        for (v = 0; v < 3; v++)
+        {
+            pointAt(&voices[v], measurements[v]);
+            __alHrtfRendererAddVoice(&renderer, &voices[v],
+                                     input + (v * frames) + (q * block));
+        } /* for */
+        __alHrtfRendererEnd(&renderer, output + (q * block * 2));
+    } /* for */
+
+    for (i = 0; i < frames; i++)
+    {
+        double expected[2] = { 0.0, 0.0 };
+        ALsizei ear;
+        for (v = 0; v < 3; v++)
+        {
+            const ALfloat *ir = irs + (measurements[v] * taps * 2);
+            const ALfloat *x = input + (v * frames);
+            for (t = 0; (t < taps) && (t <= i); t++)
+            {
+                expected[0] += ((double) ir[t]) * x[i - t];
+                expected[1] += ((double) ir[taps + t]) * x[i - t];
+            } /* for */
+        } /* for */
+
+        for (ear = 0; ear < 2; ear++)
+        {
+            const double err = fabs(output[(i * 2) + ear] - expected[ear]);
+            if (err > worst)
+                worst = err;
+            if (fabs(expected[ear]) > peak)
+                peak = fabs(expected[ear]);
+        } /* for */
+    } /* for */
+
+    /* single precision FFTs; this is plenty tight to catch a real bug. */
+    if (worst > (peak * 1e-4))
+    {
+        printf("FAIL: %d-frame quantum, %d taps: off by %g (peak %g)\n",
+               (int) block, (int) taps, worst, peak);
+        failures++;
+    } /* if */
+
+    for (v = 0; v < 3; v++)
+        __alHrtfVoiceDeinit(&voices[v]);
+    __alHrtfRendererDeinit(&renderer);
+    free(input);
+    free(output);
+} /* check */
+
+
+/* Nanoseconds per voice per quantum, with (moving) voices crossfading. */
+static double timeVoices(const __alHrirSet *set, ALsizei count,
+                         ALboolean moving, ALsizei quanta)
+{
+    const ALsizei block = set->partitionSize;
+    ALfloat *input = (ALfloat *) malloc(sizeof (ALfloat) * block);
+    ALfloat *output = (ALfloat *) malloc(sizeof (ALfloat) * block * 2);
+    __alHrtfVoice voices[MAX_VOICES];
+    __alHrtfRenderer renderer;
+    unsigned long long start, elapsed;
+    ALsizei v, q, i;
+
+    if ((input == NULL) || (output == NULL) ||
+        (!__alHrtfRendererInit(&renderer, set)))
+    {
+        free(input);
+        free(output);
+        return -1.0;
+    } /* if */
+
+    for (i = 0; i < block; i++)
+        input[i] = rng();
+
+    for (v = 0; v < count; v++)
+    {
+        if (!__alHrtfVoiceInit(&voices[v], set))
+        {
+            while (v-- > 0)
+                __alHrtfVoiceDeinit(&voices[v]);
+            __alHrtfRendererDeinit(&renderer);
+            free(input);
+            free(output);
+            return -1.0;
+        } /* if */
+        pointAt(&voices[v], v % set->count);
+        __alHrtfVoiceReset(&voices[v]);
+    } /* for */
+
+    start = __alTicksNS();
+    for (q = 0; q < quanta; q++)
+    {
+        memset(output, '\0', sizeof (ALfloat) * block * 2);
+        __alHrtfRendererBegin(&renderer);
+        for (v = 0; v < count; v++)
+        {
+            /* moving voices step to the next measurement every quantum. */
+            pointAt(&voices[v], (v + (moving ? (q + 1) : 0)) % set->count);
+            __alHrtfRendererAddVoice(&renderer, &voices[v], input);
+        } /* for */
+        __alHrtfRendererEnd(&renderer, output);
+    } /* for */
+    elapsed = __alTicksNS() - start;
+
+    for (v = 0; v < count; v++)
+        __alHrtfVoiceDeinit(&voices[v]);
+    __alHrtfRendererDeinit(&renderer);
+    free(input);
+    free(output);
+
+    return ((double) elapsed) / (((double) quanta) * count);
+} /* timeVoices */
+
+
+static void run(ALsizei block, ALsizei taps, ALsizei quanta)
+{
+    static const ALsizei voiceCounts[] = { 1, 8, 32, MAX_VOICES };
+    const double budget = (1000000000.0 * block) / FREQUENCY;
+    __alHrirSet *set;
+    ALfloat *irs = NULL;
+    size_t i;
+
+    if (!makeSet(taps, &irs))
+    {
+        printf("FAIL: couldn't write %s\n", SCRATCH_PATH);
+        failures++;
+        return;
+    } /* if */
+
+    set = __alHrirSetLoad(SCRATCH_PATH, FREQUENCY, block);
+    remove(SCRATCH_PATH);
+    if (set == NULL)
+    {
+        printf("FAIL: couldn't load the set back\n");
+        failures++;
+        free(irs);
+        return;
+    } /* if */
+
+    check(set, irs, taps);
+
+    printf("%4d-frame quantum, %4d taps (%d partitions):\n",
+           (int) block, (int) taps, (int) set->partitions);
+    for (i = 0; i < sizeof (voiceCounts) / sizeof (voiceCounts[0]); i++)
+    {
+        const ALsizei count = voiceCounts[i];
+        const double steady = timeVoices(set, count, AL_FALSE, quanta);
+        const double moving = timeVoices(set, count, AL_TRUE, quanta);
+        printf("  %3d voices: steady %8.0f ns/voice (%5.2f%% of the"
+               " quantum), moving %8.0f ns/voice\n", (int) count, steady,
+               (steady * 100.0) / budget, moving);
+    } /* for */
+
+    __alHrirSetFree(set);
+    free(irs);
+} /* run */
+
+
+int main(int argc, char **argv)
+{
+    ALsizei quanta = (argc > 1) ? (ALsizei) atoi(argv[1]) : 2000;
+    if (quanta <= 0)
+        quanta = 2000;
+
+    run(128, 256, quanta);
+    run(256, 256, quanta);
+    run(256, 512, quanta);
+    run(512, 200, quanta);  /* a ragged last partition. */
+
+    if (failures == 0)
+        printf("Partitioned convolution matches direct convolution.\n");
+    else
+        printf("%d failures.\n", failures);
+
+    return (failures == 0) ? 0 : 1;
+} /* main */
+
+/* end of benchhrtf.c ... */
@@ -0,0 +1,199 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * How big uploads scale with worker threads: __alSampleImportParallel()
+ *  converting a minute of 16-bit stereo to float, and __alAdpcmEncode()
+ *  compressing it to IMA, each on pools of one thread up to one per CPU
+ *  core. Both promise the same bytes no matter how many threads did the
+ *  work, so every run is also compared against a run with no pool at all.
+ *
+ * Build it like benchadpcm.c:
+ *
+ *   cc -O2 -I../src benchparallel.c ../src/alSample.c ../src/alAdpcm.c \
+ *      ../src/alWorker.c ../src/alQueue.c ../src/alThread.c -lpthread
+ *
+ * Pass a number of passes on the command line for steadier numbers, and a
+ *  thread count after that to go past the number of cores. It exits
+ *  non-zero if any output differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alc.h"
+#include "alSample.h"
+#include "alAdpcm.h"
+#include "alWorker.h"
+#include "alThread.h"
+
+#define BENCH_FRAMES (48000 * 60)
+#define BENCH_CHANNELS 2
+#define BENCH_SAMPLES (BENCH_FRAMES * BENCH_CHANNELS)
+
+static int failures = 0;
+
+static double perSecond(unsigned long long frames, unsigned long long ns)
+{
+    return (ns == 0) ? 0.0 : (((double) frames) * 1000000000.0) / ns;
+} /* perSecond */
+
+
+/* Returns the time for (passes) imports, or zero if it didn't match. */
+static unsigned long long benchImport(__alWorkerPool *pool,
+                                      const ALshort *pcm, ALfloat *out,
+                                      const ALfloat *expected, int passes)
+{
+    unsigned long long start, elapsed;
+    int pass;
+
+    start = __alTicksNS();
+    for (pass = 0; pass < passes; pass++)
+    {
+        __alSampleImportParallel(pool, AL_STORAGE_FLOAT32_IOAL, out,
+                                 AL_FORMAT_STEREO16, pcm, BENCH_SAMPLES);
+    } /* for */
+    elapsed = __alTicksNS() - start;
+
+    if (memcmp(out, expected, sizeof (ALfloat) * BENCH_SAMPLES) != 0)
+        return 0;
+    return elapsed;
+} /* benchImport */
+
+
+static unsigned long long benchEncode(__alWorkerPool *pool,
+                                      const ALshort *pcm,
+                                      const __alAdpcm *expected, int passes)
+{
+    const size_t size = ((size_t) expected->blockAlign) *
+                        expected->blockCount;
+    unsigned long long start, elapsed = 0;
+    int pass;
+
+    for (pass = 0; pass < passes; pass++)
+    {
+        __alAdpcm adpcm;
+        int same;
+
+        start = __alTicksNS();
+        if (__alAdpcmEncode(&adpcm, pcm, BENCH_FRAMES, BENCH_CHANNELS, 0,
+                            pool) != AL_NO_ERROR)
+            return 0;
+        elapsed += __alTicksNS() - start;
+
+        same = ((adpcm.blockCount == expected->blockCount) &&
+                (memcmp(adpcm.blocks, expected->blocks, size) == 0));
+        __alAdpcmFree(&adpcm);
+        if (!same)
+            return 0;
+    } /* for */
+
+    return elapsed;
+} /* benchEncode */
+
+
+int main(int argc, char **argv)
+{
+    int passes = (argc > 1) ? atoi(argv[1]) : 5;
+    int maxThreads = (argc > 2) ? atoi(argv[2]) : (int) __alCpuCount();
+    ALshort *pcm = (ALshort *) malloc(sizeof (ALshort) * BENCH_SAMPLES);
+    ALfloat *expectedFloat = (ALfloat *) malloc(sizeof (ALfloat) *
+                                                BENCH_SAMPLES);
+    ALfloat *out = (ALfloat *) malloc(sizeof (ALfloat) * BENCH_SAMPLES);
+    unsigned int seed = 0x2545F491;
+    __alAdpcm expectedAdpcm;
+    int threads;
+    ALsizei i;
+
+    if (passes <= 0)
+        passes = 5;
+    if (maxThreads <= 0)
+        maxThreads = 1;
+
+    if ((pcm == NULL) || (expectedFloat == NULL) || (out == NULL))
+    {
+        printf("FAIL: out of memory\n");
+        free(pcm);
+        free(expectedFloat);
+        free(out);
+        return 1;
+    } /* if */
+
+    for (i = 0; i < BENCH_SAMPLES; i++)
+    {
+        /* a rising sweep with some noise on it, like testadpcm.c. */
+        const ALint saw = (ALint) ((i * (37 + (i / 997))) & 0xFFFF) - 32768;
+        seed = (seed * 1103515245) + 12345;
+        pcm[i] = (ALshort) ((saw / 2) + ((ALint) ((seed >> 16) & 0x3FF) -
+                                         512));
+    } /* for */
+
+    /* the references: everything on this thread. */
+    __alSampleImport(AL_STORAGE_FLOAT32_IOAL, expectedFloat,
+                     AL_FORMAT_STEREO16, pcm, BENCH_SAMPLES);
+    if (__alAdpcmEncode(&expectedAdpcm, pcm, BENCH_FRAMES, BENCH_CHANNELS,
+                        0, NULL) != AL_NO_ERROR)
+    {
+        printf("FAIL: couldn't encode\n");
+        free(pcm);
+        free(expectedFloat);
+        free(out);
+        return 1;
+    } /* if */
+
+    for (threads = 1; threads <= maxThreads; threads++)
+    {
+        const unsigned long long frames =
+            ((unsigned long long) BENCH_FRAMES) * passes;
+        unsigned long long import, encode;
+        __alWorkerPool pool;
+
+        if (!__alWorkerPoolInit(&pool, (ALuint) threads, 256))
+        {
+            printf("FAIL: couldn't start %d threads\n", threads);
+            failures++;
+            break;
+        } /* if */
+
+        memset(out, '\0', sizeof (ALfloat) * BENCH_SAMPLES);
+        import = benchImport(&pool, pcm, out, expectedFloat, passes);
+        encode = benchEncode(&pool, pcm, &expectedAdpcm, passes);
+        __alWorkerPoolDeinit(&pool);
+
+        if (import == 0)
+        {
+            printf("FAIL: import on %d threads doesn't match\n", threads);
+            failures++;
+        } /* if */
+        if (encode == 0)
+        {
+            printf("FAIL: encode on %d threads doesn't match\n", threads);
+            failures++;
+        } /* if */
+
+        printf("%2d threads: import %8.1f Mframes/s, IMA encode"
+               " %8.1f Mframes/s\n", threads,
+               perSecond(frames, import) / 1000000.0,
+               perSecond(frames, encode) / 1000000.0);
+    } /* for */
+
+    if (failures == 0)
+        printf("Every thread count gave the same bytes.\n");
+    else
+        printf("%d failures.\n", failures);
+
+    __alAdpcmFree(&expectedAdpcm);
+    free(pcm);
+    free(expectedFloat);
+    free(out);
+    return (failures == 0) ? 0 : 1;
+} /* main */
+
+/* end of benchparallel.c ... */
@@ -0,0 +1,277 @@
+/**
+ * An OpenAL implementation.
+ *
+ * Please see the file LICENSE in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * Bit-exactness test for the ADPCM decoders. __alAdpcmDecodeBlock() on a
+ *  mono or stereo block never fills enough SIMD lanes to leave the scalar
+ *  decoders, so a loop of it is our reference; __alAdpcmDecodeBlocks()
+ *  and the mixer's block cache must match it sample for sample, for
+ *  every codec, channel count, block size and batch length we try.
+ *
+ * Build it with the AL headers in the include path, something like:
+ *
+ *   cc -O2 -I../src testadpcm.c ../src/alAdpcm.c ../src/alWorker.c \
+ *      ../src/alQueue.c ../src/alThread.c -lpthread
+ *
+ * It prints each failure and exits non-zero if there were any.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "al.h"
+#include "alc.h"
+#include "alAdpcm.h"
+
+static int failures = 0;
+
+/* a small, repeatable PRNG; rand() differs between C libraries. */
+static unsigned int rngState = 0x12345678;
+static unsigned int rng(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+} /* rng */
+
+
+static void check(const char *what, ALenum fmt, ALsizei blockFrames,
+                  const ALshort *expected, const ALshort *got, ALsizei count)
+{
+    ALsizei i;
+    for (i = 0; i < count; i++)
+    {
+        if (expected[i] != got[i])
+        {
+            printf("FAIL: %s, format 0x%X, %d-frame blocks: sample %d is"
+                   " %d, should be %d\n", what, (unsigned int) fmt,
+                   (int) blockFrames, (int) i, (int) got[i],
+                   (int) expected[i]);
+            failures++;
+            return;
+        } /* if */
+    } /* for */
+} /* check */
+
+
+static void testData(const __alAdpcm *adpcm, ALenum fmt, ALsizei blockFrames)
+{
+    const ALsizei stride = adpcm->blockFrames * adpcm->channels;
+    const ALsizei total = stride * adpcm->blockCount;
+    ALshort *expected = (ALshort *) malloc(sizeof (ALshort) * total);
+    ALshort *got = (ALshort *) malloc(sizeof (ALshort) * total);
+    __alAdpcmCache cache;
+    ALsizei first, count, i;
+
+    if ((expected == NULL) || (got == NULL))
+    {
+        printf("FAIL: out of memory\n");
+        failures++;
+        free(expected);
+        free(got);
+        return;
+    } /* if */
+
+    for (i = 0; i < adpcm->blockCount; i++)
+        __alAdpcmDecodeBlock(adpcm, i, expected + (i * stride));
+
+    /* the whole thing at once... */
+    memset(got, '\0', sizeof (ALshort) * total);
+    __alAdpcmDecodeBlocks(adpcm, 0, adpcm->blockCount, got);
+    check("DecodeBlocks, all", fmt, blockFrames, expected, got, total);
+
+    /* ...and in odd-sized batches, so every lane tail gets a turn. */
+    for (count = 1; count <= 19; count++)
+    {
+        for (first = 0; first < adpcm->blockCount; first += count)
+        {
+            ALsizei n = adpcm->blockCount - first;
+            if (n > count)
+                n = count;
+            __alAdpcmDecodeBlocks(adpcm, first, n, got + (first * stride));
+        } /* for */
+        check("DecodeBlocks, batched", fmt, blockFrames, expected, got,
+              total);
+    } /* for */
+
+    /*
+     * The cache, read forward, then back and forth around each block
+     *  boundary like an interpolating resampler would.
+     */
+    __alAdpcmCacheInit(&cache);
+    if (!__alAdpcmCacheBind(&cache, adpcm))
+    {
+        printf("FAIL: out of memory\n");
+        failures++;
+    } /* if */
+    else
+    {
+        ALsizei frame = 0;
+        while (frame < adpcm->frames)
+        {
+            ALsizei avail = 0;
+            const ALshort *ptr = __alAdpcmCacheFetch(&cache, adpcm, frame,
+                                                     &avail);
+            check("cache, forward", fmt, blockFrames,
+                  expected + (frame * adpcm->channels), ptr,
+                  avail * adpcm->channels);
+            frame += (avail > 7) ? 7 : avail;
+        } /* while */
+
+        for (i = 1; i < adpcm->blockCount; i++)
+        {
+            const ALsizei edge = i * adpcm->blockFrames;
+            static const ALsizei offsets[] = { -2, 1, -1, 0, 2, -3 };
+            size_t j;
+            for (j = 0; j < sizeof (offsets) / sizeof (offsets[0]); j++)
+            {
+                const ALsizei at = edge + offsets[j];
+                const ALshort *ptr;
+                ALsizei avail = 0;
+                if (at >= adpcm->frames)
+                    continue;
+                ptr = __alAdpcmCacheFetch(&cache, adpcm, at, &avail);
+                check("cache, boundary", fmt, blockFrames,
+                      expected + (at * adpcm->channels), ptr,
+                      avail * adpcm->channels);
+            } /* for */
+        } /* for */
+    } /* else */
+    __alAdpcmCacheDeinit(&cache);
+
+    free(expected);
+    free(got);
+} /* testData */
+
+
+static void testFormat(ALenum fmt, ALsizei blockFrames)
+{
+    const ALsizei blockAlign = __alAdpcmBlockAlign(fmt, blockFrames);
+    const ALsizei blocks = 37;
+    const ALsizei size = blockAlign * blocks;
+    ALubyte *data = (ALubyte *) malloc(size);
+    __alAdpcm adpcm;
+    ALsizei i;
+
+    if (blockAlign == 0)
+    {
+        printf("FAIL: format 0x%X can't have %d-frame blocks\n",
+               (unsigned int) fmt, (int) blockFrames);
+        failures++;
+        free(data);
+        return;
+    } /* if */
+    else if (data == NULL)
+    {
+        printf("FAIL: out of memory\n");
+        failures++;
+        return;
+    } /* else if */
+
+    /*
+     * Noise is the hard case: every nibble value, headers with step
+     *  indices and predictors out of range, samples pinned at the clamps.
+     */
+    for (i = 0; i < size; i++)
+        data[i] = (ALubyte) (rng() >> 24);
+
+    if (__alAdpcmInit(&adpcm, fmt, data, size, blockAlign, AL_FALSE) !=
+        AL_NO_ERROR)
+    {
+        printf("FAIL: couldn't set up format 0x%X, %d-frame blocks\n",
+               (unsigned int) fmt, (int) blockFrames);
+        failures++;
+    } /* if */
+    else
+    {
+        testData(&adpcm, fmt, blockFrames);
+        __alAdpcmFree(&adpcm);
+    } /* else */
+
+    free(data);
+} /* testFormat */
+
+
+/* IMA that came out of our own encoder, which is what most buffers hold. */
+static void testEncoded(ALsizei channels, ALsizei blockFrames)
+{
+    const ALenum fmt = (channels == 1) ? AL_FORMAT_MONO_IMA4 :
+                                         AL_FORMAT_STEREO_IMA4;
+    const ALsizei frames = 20000;
+    ALshort *pcm = (ALshort *) malloc(sizeof (ALshort) * frames * channels);
+    __alAdpcm adpcm;
+    ALsizei i;
+
+    if (pcm == NULL)
+    {
+        printf("FAIL: out of memory\n");
+        failures++;
+        return;
+    } /* if */
+
+    for (i = 0; i < frames * channels; i++)
+    {
+        /* a rising sweep with some noise on it. */
+        const ALint saw = (ALint) ((i * (37 + (i / 997))) & 0xFFFF) - 32768;
+        pcm[i] = (ALshort) ((saw / 2) + ((ALint) (rng() & 0x3FF) - 512));
+    } /* for */
+
+    if (__alAdpcmEncode(&adpcm, pcm, frames, channels,
+                        __alAdpcmBlockAlign(fmt, blockFrames), NULL) !=
+        AL_NO_ERROR)
+    {
+        printf("FAIL: couldn't encode %d channels, %d-frame blocks\n",
+               (int) channels, (int) blockFrames);
+        failures++;
+    } /* if */
+    else
+    {
+        testData(&adpcm, fmt, blockFrames);
+        __alAdpcmFree(&adpcm);
+    } /* else */
+
+    free(pcm);
+} /* testEncoded */
+
+
+int main(void)
+{
+    static const ALenum imaFormats[] =
+        { AL_FORMAT_MONO_IMA4, AL_FORMAT_STEREO_IMA4 };
+    static const ALenum msFormats[] =
+        { AL_FORMAT_MONO_MSADPCM_SOFT, AL_FORMAT_STEREO_MSADPCM_SOFT };
+    ALsizei i, frames;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (frames = 9; frames <= 1017; frames += 8)  /* 8n+1 */
+            testFormat(imaFormats[i], frames);
+        testFormat(imaFormats[i], 0);
+        testFormat(imaFormats[i], 8185);  /* as big as they get. */
+
+        for (frames = 4; frames <= 1024; frames += 2)
+            testFormat(msFormats[i], frames);
+        testFormat(msFormats[i], 0);
+        testFormat(msFormats[i], 8180);
+
+        testEncoded(i + 1, 0);
+        testEncoded(i + 1, 9);
+        testEncoded(i + 1, 1017);
+    } /* for */
+
+    if (failures == 0)
+        printf("All ADPCM decodes match.\n");
+    else
+        printf("%d failures.\n", failures);
+
+    return (failures == 0) ? 0 : 1;
+} /* main */
+
+/* end of testadpcm.c ... */